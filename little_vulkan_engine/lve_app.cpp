@@ -2,6 +2,7 @@
 #include "keyboard_movement_controller.hpp"
 #include "lve_camera.hpp"
 #include "lve_buffer.hpp"
+#include "lve_frame_pipeline.hpp"
 
 #include "lve_render_system.hpp"
 #include "point_light_system.hpp"
@@ -11,27 +12,88 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
 #include <stdexcept>
+#include <string>
 #include <chrono>
+#include <thread>
 
 namespace lve
 {
+    namespace
+    {
+        // world space bounds of a transformed object space box
+        void transformBounds(
+            const glm::mat4 &transform,
+            const glm::vec3 &boundsMin,
+            const glm::vec3 &boundsMax,
+            glm::vec3 &worldMin,
+            glm::vec3 &worldMax)
+        {
+            glm::vec3 center = glm::vec3(transform * glm::vec4(0.5f * (boundsMin + boundsMax), 1.f));
+            glm::vec3 extent = 0.5f * (boundsMax - boundsMin);
+            glm::vec3 worldExtent = glm::abs(glm::vec3(transform[0])) * extent.x +
+                                    glm::abs(glm::vec3(transform[1])) * extent.y +
+                                    glm::abs(glm::vec3(transform[2])) * extent.z;
+            worldMin = center - worldExtent;
+            worldMax = center + worldExtent;
+        }
+    }
+
     LveApp::LveApp()
     {
-        this->globalPool = LveDescriptorPool::Builder(this->lveDevice)
-                               .setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT)
-                               .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
-                               .build();
+        if (const char *benchmark = std::getenv(BENCHMARK_ENV))
+        {
+            this->benchmarkObjectCount = std::max(0, std::atoi(benchmark));
+        }
 
         this->loadGameObjects();
     }
 
     LveApp::~LveApp() {}
 
+    FrameConfig LveApp::frameConfigFromEnvironment()
+    {
+        const char *pacing = std::getenv(FRAME_PACING_ENV);
+        if (pacing == nullptr)
+        {
+            return FrameConfig{};
+        }
+
+        std::string mode{pacing};
+        if (mode == "low-latency")
+        {
+            return FrameConfig::lowLatency();
+        }
+        if (mode == "throughput")
+        {
+            return FrameConfig::throughput();
+        }
+
+        return FrameConfig{};
+    }
+
+    bool LveApp::bindlessFromEnvironment()
+    {
+        const char *bindless = std::getenv(BINDLESS_ENV);
+        return bindless != nullptr && std::string{bindless} == "1";
+    }
+
+    bool LveApp::pinThreads() { return std::thread::hardware_concurrency() >= PIN_THREADS_MIN_CORES; }
+
     void LveApp::run()
     {
-        std::vector<std::unique_ptr<LveBuffer>> uboBuffers(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        if (pinThreads())
+        {
+            LveJobSystem::pinCurrentThread(MAIN_THREAD_CORE);
+        }
+
+        std::vector<std::unique_ptr<LveBuffer>> uboBuffers(this->lveDevice.getFramesInFlight());
         for (int i = 0; i < uboBuffers.size(); i++)
         {
             uboBuffers[i] = std::make_unique<LveBuffer>(
@@ -44,65 +106,113 @@ namespace lve
             uboBuffers[i]->map();
         }
 
-        std::unique_ptr<LveDescriptorSetLayout> globalSetLayout = LveDescriptorSetLayout::Builder(this->lveDevice)
+        std::shared_ptr<LveDescriptorSetLayout> globalSetLayout = LveDescriptorSetLayout::Builder(this->lveDevice)
                                                                       .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
-                                                                      .build();
+                                                                      .build(this->descriptorCache);
+        // the global set is rewritten every frame, a template applies it in one call
+        std::unique_ptr<LveDescriptorUpdateTemplate> globalUpdateTemplate =
+            LveDescriptorUpdateTemplate::Builder(this->lveDevice, *globalSetLayout)
+                .addEntry(0, 0)
+                .build();
+
+        // the cheapest lighting variant covering every light in the scene, the ubo holds MAX_LIGHTS
+        LveRenderSystem::LightingVariant lighting{};
+        lighting.maxLights = std::min(static_cast<int>(this->scene.pointLights.size()), MAX_LIGHTS);
 
-        std::vector<VkDescriptorSet> globalDescriptorSets{LveSwapChain::MAX_FRAMES_IN_FLIGHT};
-        for (int i = 0; i < globalDescriptorSets.size(); i++)
+        // opted in and supported, per draw resources are looked up through the bindless table
+        std::unique_ptr<LveBindlessResources> bindless{};
+        if (bindlessFromEnvironment() && LveBindlessResources::isSupported(this->lveDevice))
         {
-            VkDescriptorBufferInfo bufferInfo = uboBuffers[i]->descriptorInfo();
-            LveDescriptorWriter(*globalSetLayout, *this->globalPool)
-                .writeBuffer(0, &bufferInfo)
-                .build(globalDescriptorSets[i]);
+            bindless = std::make_unique<LveBindlessResources>(this->lveDevice);
         }
 
-        LveRenderSystem renderSystem{this->lveDevice, this->lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
-        PointLightSystem pointLightSystem{this->lveDevice, this->lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
+        auto pipelineStart = std::chrono::high_resolution_clock::now();
+        LveRenderSystem renderSystem{
+            this->lveDevice,
+            this->pipelineService,
+            this->descriptorCache,
+            this->geometryPool,
+            this->staticBatcher,
+            this->lveRenderer.getSwapChainRenderTarget(),
+            globalSetLayout->getDescriptorSetLayout(),
+            lighting,
+            bindless.get()};
+        PointLightSystem pointLightSystem{
+            this->lveDevice,
+            this->pipelineService,
+            this->lveRenderer.getSwapChainRenderTarget(),
+            globalSetLayout->getDescriptorSetLayout()};
+        // pipelines compile in the background, wait for them only to report startup time
+        this->pipelineService.waitIdle();
+        float pipelineTime = std::chrono::duration<float, std::chrono::milliseconds::period>(
+                                 std::chrono::high_resolution_clock::now() - pipelineStart)
+                                 .count();
+        std::cout << "pipelines created in " << pipelineTime << " ms ("
+                  << (this->lveDevice.isPipelineCacheWarm() ? "warm" : "cold") << " pipeline cache, "
+                  << this->pipelineService.getPipelineCount() << " unique of "
+                  << this->pipelineService.getRequestCount() << " requested)\n";
         LveCamera camera{};
         // camera.setViewDirection(glm::vec3(0.f), glm::vec3(0.5f, 0.f, 1.f));
         // camera.setViewTarget(glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 2.5f));
 
-        auto viewerObject = LveGameObject::createGameObject();
-        viewerObject.transform.translation.z = -5.5;
-        viewerObject.transform.translation.y = -3.5;
-
-        viewerObject.transform.rotation.x = -0.6;
+        TransformComponent viewerTransform{};
+        viewerTransform.setTranslation({0.f, -3.5f, -5.5f});
+        viewerTransform.setRotation({-0.6f, 0.f, 0.f});
 
         KeyboardMovementController cameraController{};
         auto currentTime = std::chrono::high_resolution_clock::now();
+        bool depthPrepass = renderSystem.isDepthPrepassEnabled();
+        bool wireframe = renderSystem.isWireframeEnabled();
+        bool depthPrepassKeyDown = false;
+        bool wireframeKeyDown = false;
+        float benchmarkTime = 0.f;
+        int benchmarkFrames = 0;
+        bool renderThreadPinned = !pinThreads();
 
-        while (!this->lveWindow.shouldClose())
-        {
-            glfwPollEvents();
-
-            auto newTime = std::chrono::high_resolution_clock::now();
-            float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
-            currentTime = newTime;
-
-            cameraController.moveInPlaneXZ(this->lveWindow.getGLFWwindow(), frameTime, viewerObject);
-            camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+        // records and submits on the render thread while this thread simulates the next frame
+        LveFramePipeline framePipeline{[&](const RenderState &state) {
+            if (!renderThreadPinned)
+            {
+                LveJobSystem::pinCurrentThread(RENDER_THREAD_CORE);
+                renderThreadPinned = true;
+            }
 
-            float aspect = this->lveRenderer.getAspectRatio();
-            camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 30.f);
+            if (state.depthPrepass != renderSystem.isDepthPrepassEnabled())
+            {
+                renderSystem.setDepthPrepass(state.depthPrepass);
+            }
+            if (state.wireframe != renderSystem.isWireframeEnabled())
+            {
+                renderSystem.setWireframe(state.wireframe);
+            }
 
+            // uploads may move geometry, they are done before anything is recorded
+            renderSystem.prepareFrame(state);
             if (VkCommandBuffer commandBuffer = this->lveRenderer.beginFrame())
             {
                 int frameIndex = this->lveRenderer.getFrameIndex();
+
+                // beginFrame waited for this frame slot to finish, its transient sets are free again
+                this->descriptorAllocator.resetFrame(frameIndex);
+                VkDescriptorSet globalDescriptorSet =
+                    this->descriptorAllocator.allocateTransient(frameIndex, globalSetLayout->getDescriptorSetLayout());
+                VkDescriptorBufferInfo bufferInfo = uboBuffers[frameIndex]->descriptorInfo();
+                globalUpdateTemplate->update(globalDescriptorSet, &bufferInfo);
+
                 FrameInfo frameInfo{
                     frameIndex,
-                    frameTime,
+                    state.frameTime,
                     commandBuffer,
-                    camera,
-                    globalDescriptorSets[frameIndex],
-                    this->gameObjects};
+                    state.camera,
+                    globalDescriptorSet,
+                    state};
 
                 // update
                 GlobalUbo ubo{};
-                ubo.projection = camera.getProjection();
-                ubo.view = camera.getView();
-                ubo.inverseView = camera.getInverseView();
-                pointLightSystem.update(frameInfo, ubo);
+                ubo.projection = state.camera.getProjection();
+                ubo.view = state.camera.getView();
+                ubo.inverseView = state.camera.getInverseView();
+                pointLightSystem.writeLights(frameInfo, ubo);
                 uboBuffers[frameIndex]->writeToBuffer(&ubo);
                 uboBuffers[frameIndex]->flush();
 
@@ -112,37 +222,252 @@ namespace lve
                 pointLightSystem.render(frameInfo);
                 this->lveRenderer.endSwapChainRenderPass(commandBuffer);
                 this->lveRenderer.endFrame();
+                this->geometryPool.endFrame();
+            }
+        }};
+
+        while (!this->lveWindow.shouldClose())
+        {
+            glfwPollEvents();
+
+            // The render thread skips frames while the window has no area and never waits for
+            // events itself, so this thread keeps pumping them until the window is restored.
+            VkExtent2D extent = this->lveWindow.getExtent();
+            if (extent.width == 0 || extent.height == 0)
+            {
+                this->lveWindow.waitEvents();
+                currentTime = std::chrono::high_resolution_clock::now();
+                continue;
+            }
+
+            auto newTime = std::chrono::high_resolution_clock::now();
+            float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
+            currentTime = newTime;
+
+            bool keyDown = glfwGetKey(this->lveWindow.getGLFWwindow(), DEPTH_PREPASS_KEY) == GLFW_PRESS;
+            if (keyDown && !depthPrepassKeyDown)
+            {
+                depthPrepass = !depthPrepass;
+            }
+            depthPrepassKeyDown = keyDown;
+
+            keyDown = glfwGetKey(this->lveWindow.getGLFWwindow(), WIREFRAME_KEY) == GLFW_PRESS;
+            if (keyDown && !wireframeKeyDown)
+            {
+                wireframe = !wireframe;
+            }
+            wireframeKeyDown = keyDown;
+            // the render system skips the depth pre-pass while wireframe is on, lines would
+            // fail its equal depth test, and uses it again once wireframe is off
+
+            if (this->benchmarkObjectCount > 0)
+            {
+                benchmarkTime += frameTime;
+                benchmarkFrames++;
+                if (benchmarkTime >= BENCHMARK_REPORT_SECONDS)
+                {
+                    std::cout << this->benchmarkObjectCount << " objects, depth pre-pass "
+                              << (depthPrepass ? "on" : "off") << ": "
+                              << 1000.f * benchmarkTime / benchmarkFrames << " ms/frame\n";
+                    std::cout << "job workers:";
+                    for (const LveJobSystem::WorkerStats &stats : this->jobSystem.takeStats())
+                    {
+                        std::cout << " " << static_cast<int>(100.f * stats.utilization + 0.5f) << "% ("
+                                  << stats.jobs << " jobs)";
+                    }
+                    std::cout << "\n";
+                    depthPrepass = !depthPrepass;
+                    benchmarkTime = 0.f;
+                    benchmarkFrames = 0;
+                }
             }
+
+            cameraController.moveInPlaneXZ(this->lveWindow.getGLFWwindow(), frameTime, viewerTransform);
+            camera.setViewYXZ(viewerTransform.getTranslation(), viewerTransform.getRotation());
+
+            // the swap chain belongs to the render thread, the window has the same extent
+            float aspect = static_cast<float>(extent.width) / static_cast<float>(extent.height);
+            camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 30.f);
+
+            pointLightSystem.update(frameTime, this->scene, this->jobSystem);
+            this->scene.updateTransforms(this->jobSystem);
+
+            RenderState &state = framePipeline.getWriteState();
+            this->extractRenderState(state, camera, frameTime);
+            state.depthPrepass = depthPrepass;
+            state.wireframe = wireframe;
+            // The batches are read while recording and the registry evicts models the render
+            // thread draws, both only change while it waits.
+            framePipeline.publish([this]() {
+                this->staticBatcher.update(this->scene);
+                this->modelRegistry.endFrame();
+            });
         }
 
-        vkDeviceWaitIdle(this->lveDevice.device());
+        framePipeline.finish();
+        this->lveDevice.waitIdle();
     };
 
+    void LveApp::extractRenderState(RenderState &state, const LveCamera &camera, float frameTime)
+    {
+        state.frameTime = frameTime;
+        state.camera = camera;
+
+        state.lights.clear();
+        const std::vector<LveScene::id_t> &lightIds = this->scene.pointLights.getIds();
+        const std::vector<PointLightComponent> &lights = this->scene.pointLights.getComponents();
+        for (size_t i = 0; i < lightIds.size(); i++)
+        {
+            const TransformComponent &transform = this->scene.transforms.get(lightIds[i]);
+            state.lights.push_back({
+                transform.getTranslation(),
+                glm::vec4(lights[i].color, lights[i].lightIntesity),
+                transform.getScale().x});
+        }
+
+        // world bounds only follow the transforms that changed since the last frame
+        for (LveScene::id_t id : this->scene.getDirtyTransforms())
+        {
+            if (ModelComponent *model = this->scene.models.find(id))
+            {
+                model->boundsModel = nullptr;
+            }
+        }
+        this->extractObjectUpdates(state);
+
+        // Culling runs on the job system into fixed slots, compacted afterwards. Static objects
+        // are drawn as part of their batch, which the render system culls itself.
+        const std::vector<LveScene::id_t> &modelIds = this->scene.models.getIds();
+        std::vector<ModelComponent> &models = this->scene.models.getComponents();
+        uint32_t candidateCount = static_cast<uint32_t>(modelIds.size());
+        state.objects.resize(candidateCount);
+        this->extractVisible.resize(candidateCount);
+        this->jobSystem.parallelFor(candidateCount, EXTRACT_GRAIN, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                ModelComponent &model = models[i];
+                // a cleared model draws nothing, extractObjectUpdates gave it no slot either
+                if (model.model == nullptr || LveStaticBatcher::canBatch(model))
+                {
+                    this->extractVisible[i] = false;
+                    continue;
+                }
+
+                const TransformComponent &transform = this->scene.transforms.get(modelIds[i]);
+                if (model.boundsModel != model.model.get())
+                {
+                    transformBounds(
+                        transform.mat4(),
+                        model.model->getBoundsMin(),
+                        model.model->getBoundsMax(),
+                        model.worldBoundsMin,
+                        model.worldBoundsMax);
+                    model.boundsModel = model.model.get();
+                }
+
+                this->extractVisible[i] = camera.isBoxVisible(model.worldBoundsMin, model.worldBoundsMax);
+                if (this->extractVisible[i])
+                {
+                    RenderObject &object = state.objects[i];
+                    object.id = modelIds[i];
+                    object.model = model.model.get();
+                    object.objectSlot = INVALID_OBJECT_SLOT;
+                    if (modelIds[i] < this->objectSlots.size())
+                    {
+                        object.objectSlot = this->objectSlots[modelIds[i]];
+                    }
+                    assert(object.objectSlot != INVALID_OBJECT_SLOT && "model set without LveScene::setModel");
+                }
+            }
+        });
+
+        uint32_t visibleCount = 0;
+        for (uint32_t i = 0; i < candidateCount; i++)
+        {
+            if (this->extractVisible[i])
+            {
+                state.objects[visibleCount++] = state.objects[i];
+            }
+        }
+        state.objects.resize(visibleCount);
+    }
+
+    void LveApp::extractObjectUpdates(RenderState &state)
+    {
+        state.objectUpdates.clear();
+        for (LveScene::id_t id : this->scene.getDestroyedEntities())
+        {
+            this->releaseObjectSlot(id);
+        }
+
+        for (LveScene::id_t id : this->scene.getDirtyTransforms())
+        {
+            const ModelComponent *model = this->scene.models.find(id);
+            if (model == nullptr || model->model == nullptr || LveStaticBatcher::canBatch(*model))
+            {
+                this->releaseObjectSlot(id);
+                continue;
+            }
+
+            if (id >= this->objectSlots.size())
+            {
+                this->objectSlots.resize(static_cast<size_t>(id) + 1, INVALID_OBJECT_SLOT);
+            }
+
+            uint32_t &slot = this->objectSlots[id];
+            if (slot == INVALID_OBJECT_SLOT && !this->freeObjectSlots.empty())
+            {
+                slot = this->freeObjectSlots.back();
+                this->freeObjectSlots.pop_back();
+            }
+            else if (slot == INVALID_OBJECT_SLOT)
+            {
+                slot = LveRenderSystem::FIRST_OBJECT_SLOT + this->objectSlotCount++;
+            }
+
+            const TransformComponent &transform = this->scene.transforms.get(id);
+            ObjectUpdate update{};
+            update.objectSlot = slot;
+            update.modelMatrix = transform.mat4();
+            update.normalMatrix = transform.normalMatrix();
+            state.objectUpdates.push_back(update);
+        }
+    }
+
+    void LveApp::releaseObjectSlot(LveScene::id_t id)
+    {
+        if (id < this->objectSlots.size() && this->objectSlots[id] != INVALID_OBJECT_SLOT)
+        {
+            this->freeObjectSlots.push_back(this->objectSlots[id]);
+            this->objectSlots[id] = INVALID_OBJECT_SLOT;
+        }
+    }
+
     void LveApp::loadGameObjects()
     {
-        std::shared_ptr<LveModel> flatVaseModel = LveModel::createModelFromFile(this->lveDevice, "models/flat_vase.obj");
-        LveGameObject flatVase = LveGameObject::createGameObject();
-        flatVase.model = flatVaseModel;
-        flatVase.transform.translation = {-0.5f, .5f, 0.0f};
-        flatVase.transform.scale = glm::vec3{3.f, 1.5f, 3.f};
-        this->gameObjects.emplace(flatVase.getId(), std::move(flatVase));
-
-        std::shared_ptr<LveModel> smoothVaseModel = LveModel::createModelFromFile(this->lveDevice, "models/smooth_vase.obj");
-        LveGameObject smoothVase = LveGameObject::createGameObject();
-        smoothVase.model = smoothVaseModel;
-        smoothVase.transform.translation = {.5f, .5f, 0.0f};
-        smoothVase.transform.scale = glm::vec3{3.f, 1.5f, 3.f};
-        this->gameObjects.emplace(smoothVase.getId(), std::move(smoothVase));
-
-        std::shared_ptr<LveModel> floorModel = LveModel::createModelFromFile(this->lveDevice, "models/quad.obj");
-        LveGameObject floor = LveGameObject::createGameObject();
-        floor.model = floorModel;
-        floor.transform.translation = {.5f, .5f, 0.0f};
-        floor.transform.scale = glm::vec3{3.f, 1.5f, 3.f};
-        this->gameObjects.emplace(floor.getId(), std::move(floor));
-
-        // auto pointLight = LveGameObject::makePointLight(0.2f);
-        // this->gameObjects.emplace(pointLight.getId(), std::move(pointLight));
+        std::vector<std::shared_ptr<LveModel>> models = this->modelRegistry.load(
+            {"models/flat_vase.obj", "models/smooth_vase.obj", "models/quad.obj"},
+            this->jobSystem);
+
+        LveScene::id_t flatVase = this->scene.createEntity();
+        this->scene.setModel(flatVase, models[0], true);
+        TransformComponent &flatVaseTransform = this->scene.transforms.get(flatVase);
+        flatVaseTransform.setTranslation({-0.5f, .5f, 0.0f});
+        flatVaseTransform.setScale({3.f, 1.5f, 3.f});
+
+        LveScene::id_t smoothVase = this->scene.createEntity();
+        this->scene.setModel(smoothVase, models[1], true);
+        TransformComponent &smoothVaseTransform = this->scene.transforms.get(smoothVase);
+        smoothVaseTransform.setTranslation({.5f, .5f, 0.0f});
+        smoothVaseTransform.setScale({3.f, 1.5f, 3.f});
+
+        LveScene::id_t floor = this->scene.createEntity();
+        this->scene.setModel(floor, models[2], true);
+        TransformComponent &floorTransform = this->scene.transforms.get(floor);
+        floorTransform.setTranslation({.5f, .5f, 0.0f});
+        floorTransform.setScale({3.f, 1.5f, 3.f});
+
+        // this->scene.createPointLight(0.2f);
         std::vector<glm::vec3> lightColors{
             {1.f, .1f, .1f},
             {.1f, .1f, 1.f},
@@ -153,14 +478,38 @@ namespace lve
         };
 
         for (int i = 0; i < lightColors.size(); i++) {
-            auto pointLight = LveGameObject::makePointLight(0.2f);
-            pointLight.color = lightColors[i];
+            LveScene::id_t pointLight = this->scene.createPointLight(0.2f, 0.1f, lightColors[i]);
             auto rotateLight = glm::rotate(
                 glm::mat4(1.f),
                 (i * glm::two_pi<float>()) / lightColors.size(),
                 {0.f, -1.f, 0.f});
-            pointLight.transform.translation = glm::vec3(rotateLight * glm::vec4(-1.f, -1.f, -1.f, 1.f));
-            gameObjects.emplace(pointLight.getId(), std::move(pointLight));
+            this->scene.transforms.get(pointLight).setTranslation(glm::vec3(rotateLight * glm::vec4(-1.f, -1.f, -1.f, 1.f)));
+        }
+
+        // the first frame sees every entity as changed, which builds the batches and object slots
+        this->loadBenchmarkObjects(this->benchmarkObjectCount);
+    }
+
+    void LveApp::loadBenchmarkObjects(int count)
+    {
+        if (count <= 0)
+        {
+            return;
+        }
+
+        // rows of vases receding from the camera, so most fragments are overdrawn
+        std::shared_ptr<LveModel> vaseModel = this->modelRegistry.load("models/smooth_vase.obj");
+        int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+        for (int i = 0; i < count; i++)
+        {
+            LveScene::id_t vase = this->scene.createEntity();
+            this->scene.setModel(vase, vaseModel);
+            TransformComponent &transform = this->scene.transforms.get(vase);
+            transform.setTranslation({
+                0.25f * static_cast<float>(i % columns - columns / 2),
+                .5f,
+                0.25f * static_cast<float>(i / columns)});
+            transform.setScale({3.f, 1.5f, 3.f});
         }
     }
 }
@@ -1,11 +1,19 @@
 #pragma once
 
-#include "lve_game_object.hpp"
+#include "lve_camera.hpp"
+#include "lve_frame_info.hpp"
 #include "lve_window.hpp"
 #include "lve_device.hpp"
 #include "lve_renderer.hpp"
+#include "lve_scene.hpp"
 #include "lve_descriptors.hpp"
+#include "lve_geometry_pool.hpp"
+#include "lve_job_system.hpp"
+#include "lve_model_registry.hpp"
+#include "lve_pipeline_service.hpp"
+#include "lve_static_batcher.hpp"
 
+#include <limits>
 #include <memory>
 #include <vector>
 
@@ -16,6 +24,27 @@ namespace lve
     public:
         static constexpr int HEIGHT = 600;
         static constexpr int WIDTH = 800;
+        // toggles the depth pre-pass of the render system
+        static constexpr int DEPTH_PREPASS_KEY = GLFW_KEY_P;
+        // toggles wireframe rendering
+        static constexpr int WIREFRAME_KEY = GLFW_KEY_F1;
+        // Setting this environment variable to an object count fills the scene with that many
+        // vases and prints frame times, alternating the depth pre-pass between reports.
+        static constexpr const char *BENCHMARK_ENV = "LVE_BENCHMARK_OBJECTS";
+        static constexpr float BENCHMARK_REPORT_SECONDS = 2.f;
+        // "low-latency" or "throughput" picks the frame pacing, anything else keeps the default
+        static constexpr const char *FRAME_PACING_ENV = "LVE_FRAME_PACING";
+        // "1" looks per draw resources up through the bindless table where the device supports
+        // it, off by default
+        static constexpr const char *BINDLESS_ENV = "LVE_BINDLESS";
+        // With this many hardware threads the main and render thread get a core each that the
+        // job workers stay off.
+        static constexpr uint32_t PIN_THREADS_MIN_CORES = 4;
+        static constexpr uint32_t MAIN_THREAD_CORE = 0;
+        static constexpr uint32_t RENDER_THREAD_CORE = 1;
+        // game objects culled per job
+        static constexpr uint32_t EXTRACT_GRAIN = 256;
+        static constexpr uint32_t INVALID_OBJECT_SLOT = std::numeric_limits<uint32_t>::max();
 
         LveApp();
         ~LveApp();
@@ -26,13 +55,35 @@ namespace lve
         void run();
 
     private:
+        static FrameConfig frameConfigFromEnvironment();
+        static bool bindlessFromEnvironment();
+        static bool pinThreads();
         void loadGameObjects();
+        // copies what the render thread needs out of the game objects
+        void extractRenderState(RenderState &state, const LveCamera &camera, float frameTime);
+        // assigns object slots and lists the per object data that changed this frame
+        void extractObjectUpdates(RenderState &state);
+        void releaseObjectSlot(LveScene::id_t id);
+        void loadBenchmarkObjects(int count);
 
+        LveJobSystem jobSystem{0, pinThreads() ? 2u : 0u};
         LveWindow lveWindow{WIDTH, HEIGHT, "Little Vulkan Engine!"};
-        LveDevice lveDevice{lveWindow};
+        LveDevice lveDevice{lveWindow, frameConfigFromEnvironment()};
         LveRenderer lveRenderer{lveWindow, lveDevice};
+        LvePipelineService pipelineService{lveDevice, jobSystem};
+        LveGeometryPool geometryPool{lveDevice, LveModel::Vertex::getStreamStrides()};
+        LveModelRegistry modelRegistry{geometryPool};
+        LveStaticBatcher staticBatcher{geometryPool};
 
-        std::unique_ptr<LveDescriptorPool> globalPool{};
-        LveGameObject::Map gameObjects;
+        LveDescriptorAllocator descriptorAllocator{lveDevice};
+        LveDescriptorCache descriptorCache{lveDevice, descriptorAllocator};
+        LveScene scene{};
+        // extraction scratch, whether each model component passed culling
+        std::vector<uint8_t> extractVisible{};
+        // object slot of each entity drawn on its own, by entity id
+        std::vector<uint32_t> objectSlots{};
+        std::vector<uint32_t> freeObjectSlots{};
+        uint32_t objectSlotCount = 0;
+        int benchmarkObjectCount = 0;
     };
 }
@@ -0,0 +1,138 @@
+#include "lve_bindless.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace lve
+{
+    LveBindlessResources::LveBindlessResources(
+        LveDevice &device, uint32_t maxBuffers, uint32_t maxImages, uint32_t maxSamplers)
+        : lveDevice{device}
+    {
+        if (!isSupported(device))
+        {
+            throw std::runtime_error("bindless resources need VK_EXT_descriptor_indexing!");
+        }
+
+        this->buffers->capacity = std::max(1u, std::min(maxBuffers, device.descriptorIndexing.maxStorageBuffers));
+        this->images->capacity = std::max(1u, std::min(maxImages, device.descriptorIndexing.maxSampledImages));
+        this->samplers->capacity = std::max(1u, std::min(maxSamplers, device.descriptorIndexing.maxSamplers));
+
+        VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+                                                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+                                                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+        this->setLayout = LveDescriptorSetLayout::Builder(this->lveDevice)
+                              .addBinding(BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS, this->buffers->capacity, bindingFlags)
+                              .addBinding(IMAGE_BINDING, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_ALL_GRAPHICS, this->images->capacity, bindingFlags)
+                              .addBinding(SAMPLER_BINDING, VK_DESCRIPTOR_TYPE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS, this->samplers->capacity, bindingFlags)
+                              .build();
+        this->pool = LveDescriptorPool::Builder(this->lveDevice)
+                         .setMaxSets(1)
+                         .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT)
+                         .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, this->buffers->capacity)
+                         .addPoolSize(VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, this->images->capacity)
+                         .addPoolSize(VK_DESCRIPTOR_TYPE_SAMPLER, this->samplers->capacity)
+                         .build();
+
+        if (!this->pool->allocateDescriptor(this->setLayout->getDescriptorSetLayout(), this->descriptorSet))
+        {
+            throw std::runtime_error("failed to allocate bindless descriptor set!");
+        }
+    }
+
+    LveBindlessResources::~LveBindlessResources() {}
+
+    LveBindlessResources::index_t LveBindlessResources::Slots::acquire(const char *kind)
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        if (!this->freeIndices.empty())
+        {
+            index_t index = this->freeIndices.back();
+            this->freeIndices.pop_back();
+            return index;
+        }
+
+        if (this->next >= this->capacity)
+        {
+            throw std::runtime_error(std::string("bindless ") + kind + " table is full!");
+        }
+
+        return this->next++;
+    }
+
+    void LveBindlessResources::release(const std::shared_ptr<Slots> &slots, index_t index)
+    {
+        {
+            std::lock_guard<std::mutex> lock{slots->mutex};
+            assert(index < slots->next && "Bindless index was never handed out");
+        }
+
+        // on the same clock as every other resource frames in flight may still read
+        this->lveDevice.deferDestroy([slots, index]() {
+            std::lock_guard<std::mutex> lock{slots->mutex};
+            slots->freeIndices.push_back(index);
+        });
+    }
+
+    void LveBindlessResources::write(
+        uint32_t binding,
+        index_t index,
+        const VkDescriptorBufferInfo *bufferInfo,
+        const VkDescriptorImageInfo *imageInfo)
+    {
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = this->descriptorSet;
+        write.dstBinding = binding;
+        write.dstArrayElement = index;
+        write.descriptorCount = 1;
+        write.pBufferInfo = bufferInfo;
+        write.pImageInfo = imageInfo;
+
+        if (bufferInfo != nullptr)
+        {
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        }
+        else
+        {
+            write.descriptorType = binding == IMAGE_BINDING ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLER;
+        }
+
+        // update-after-bind, safe while command buffers using other slots are pending
+        vkUpdateDescriptorSets(this->lveDevice.device(), 1, &write, 0, nullptr);
+    }
+
+    LveBindlessResources::index_t LveBindlessResources::addBuffer(const VkDescriptorBufferInfo &bufferInfo)
+    {
+        index_t index = this->buffers->acquire("buffer");
+        this->write(BUFFER_BINDING, index, &bufferInfo, nullptr);
+        return index;
+    }
+
+    LveBindlessResources::index_t LveBindlessResources::addImage(VkImageView imageView, VkImageLayout imageLayout)
+    {
+        index_t index = this->images->acquire("image");
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageView = imageView;
+        imageInfo.imageLayout = imageLayout;
+        this->write(IMAGE_BINDING, index, nullptr, &imageInfo);
+        return index;
+    }
+
+    LveBindlessResources::index_t LveBindlessResources::addSampler(VkSampler sampler)
+    {
+        index_t index = this->samplers->acquire("sampler");
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.sampler = sampler;
+        this->write(SAMPLER_BINDING, index, nullptr, &imageInfo);
+        return index;
+    }
+
+    void LveBindlessResources::removeBuffer(index_t index) { this->release(this->buffers, index); }
+
+    void LveBindlessResources::removeImage(index_t index) { this->release(this->images, index); }
+
+    void LveBindlessResources::removeSampler(index_t index) { this->release(this->samplers, index); }
+}
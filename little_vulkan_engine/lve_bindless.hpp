@@ -0,0 +1,87 @@
+#pragma once
+
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve
+{
+    // Opt-in bindless resource model on top of VK_EXT_descriptor_indexing. One global set holds
+    // large partially bound arrays of storage buffers, sampled images and samplers that can be
+    // updated after the set was bound; resources are referenced by the index returned when they
+    // were added, e.g. from per-draw object data, so nothing has to be rebound per draw.
+    //
+    //   layout(set = N, binding = 0) readonly buffer Buffers { ... } buffers[];
+    //   layout(set = N, binding = 1) uniform texture2D images[];
+    //   layout(set = N, binding = 2) uniform sampler samplers[];
+    class LveBindlessResources
+    {
+    public:
+        using index_t = uint32_t;
+
+        static constexpr uint32_t BUFFER_BINDING = 0;
+        static constexpr uint32_t IMAGE_BINDING = 1;
+        static constexpr uint32_t SAMPLER_BINDING = 2;
+        static constexpr uint32_t DEFAULT_MAX_BUFFERS = 1 << 14;
+        static constexpr uint32_t DEFAULT_MAX_IMAGES = 1 << 14;
+        static constexpr uint32_t DEFAULT_MAX_SAMPLERS = 64;
+
+        static bool isSupported(const LveDevice &device) { return device.descriptorIndexing.supported; }
+
+        // array sizes are clamped to the device limits
+        LveBindlessResources(
+            LveDevice &device,
+            uint32_t maxBuffers = DEFAULT_MAX_BUFFERS,
+            uint32_t maxImages = DEFAULT_MAX_IMAGES,
+            uint32_t maxSamplers = DEFAULT_MAX_SAMPLERS);
+        ~LveBindlessResources();
+
+        LveBindlessResources(const LveBindlessResources &) = delete;
+        LveBindlessResources &operator=(const LveBindlessResources &) = delete;
+
+        index_t addBuffer(const VkDescriptorBufferInfo &bufferInfo);
+        index_t addImage(VkImageView imageView, VkImageLayout imageLayout);
+        index_t addSampler(VkSampler sampler);
+
+        // Indices go back through LveDevice::deferDestroy and are reused only once the frames
+        // submitted before the removal retired, so those never see a slot change under them.
+        void removeBuffer(index_t index);
+        void removeImage(index_t index);
+        void removeSampler(index_t index);
+
+        VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+        VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+
+    private:
+        // shared with the deferred destructions returning indices, which may run after the
+        // table is gone and on whichever thread completes frames
+        struct Slots
+        {
+            index_t acquire(const char *kind);
+
+            std::mutex mutex;
+            uint32_t capacity = 0;
+            index_t next = 0;
+            std::vector<index_t> freeIndices{};
+        };
+
+        void release(const std::shared_ptr<Slots> &slots, index_t index);
+        void write(
+            uint32_t binding,
+            index_t index,
+            const VkDescriptorBufferInfo *bufferInfo,
+            const VkDescriptorImageInfo *imageInfo);
+
+        LveDevice &lveDevice;
+        std::unique_ptr<LveDescriptorSetLayout> setLayout;
+        std::unique_ptr<LveDescriptorPool> pool;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+        std::shared_ptr<Slots> buffers = std::make_shared<Slots>();
+        std::shared_ptr<Slots> images = std::make_shared<Slots>();
+        std::shared_ptr<Slots> samplers = std::make_shared<Slots>();
+    };
+}
@@ -32,8 +32,16 @@ namespace lve
     LveBuffer::~LveBuffer()
     {
         this->unmap();
-        vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
-        vkFreeMemory(lveDevice.device(), memory, nullptr);
+        lveDevice.releaseHandle(reinterpret_cast<uint64_t>(this->buffer));
+
+        // frames in flight may still read the buffer
+        VkDevice device = lveDevice.device();
+        VkBuffer buffer = this->buffer;
+        VkDeviceMemory memory = this->memory;
+        lveDevice.deferDestroy([device, buffer, memory]() {
+            vkDestroyBuffer(device, buffer, nullptr);
+            vkFreeMemory(device, memory, nullptr);
+        });
     }
 
     /**
@@ -118,4 +118,37 @@ namespace lve
         inverseViewMatrix[3][1] = position.y;
         inverseViewMatrix[3][2] = position.z;
     }
+
+    bool LveCamera::isBoxVisible(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax) const
+    {
+        const glm::mat4 clip = this->projectionMatrix * this->viewMatrix;
+        const glm::vec4 row0{clip[0][0], clip[1][0], clip[2][0], clip[3][0]};
+        const glm::vec4 row1{clip[0][1], clip[1][1], clip[2][1], clip[3][1]};
+        const glm::vec4 row2{clip[0][2], clip[1][2], clip[2][2], clip[3][2]};
+        const glm::vec4 row3{clip[0][3], clip[1][3], clip[2][3], clip[3][3]};
+
+        // left, right, top, bottom, near (depth zero to one) and far planes
+        const glm::vec4 planes[6] = {
+            row3 + row0,
+            row3 - row0,
+            row3 + row1,
+            row3 - row1,
+            row2,
+            row3 - row2};
+
+        for (const glm::vec4 &plane : planes)
+        {
+            // the box corner furthest along the plane normal
+            const glm::vec3 corner{
+                plane.x >= 0.f ? boundsMax.x : boundsMin.x,
+                plane.y >= 0.f ? boundsMax.y : boundsMin.y,
+                plane.z >= 0.f ? boundsMax.z : boundsMin.z};
+            if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.f)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
 }
@@ -33,6 +33,9 @@ namespace lve
         const glm::mat4 &getInverseView() const { return inverseViewMatrix; }
         const glm::vec3 getPosition() const { return glm::vec3(inverseViewMatrix[3]); }
 
+        // conservative frustum test of a world space axis aligned bounding box
+        bool isBoxVisible(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax) const;
+
     private:
         glm::mat4 projectionMatrix{1.f};
         glm::mat4 viewMatrix{1.f};
@@ -1,15 +1,51 @@
 #include "lve_descriptors.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <stdexcept>
+#include <type_traits>
 
 namespace lve
 {
+    namespace
+    {
+        template <typename T>
+        void appendKey(std::string &key, const T &value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "descriptor key fields must be plain values");
+            key.append(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        std::vector<VkDescriptorSetLayoutBinding> sortedBindings(
+            const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> &bindings)
+        {
+            std::vector<VkDescriptorSetLayoutBinding> sorted{};
+            for (auto kv : bindings)
+            {
+                sorted.push_back(kv.second);
+            }
+            std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+                return a.binding < b.binding;
+            });
+
+            return sorted;
+        }
+    }
+
+    LveDescriptorSetLayout::Builder &LveDescriptorSetLayout::Builder::setLayoutFlags(
+        VkDescriptorSetLayoutCreateFlags flags)
+    {
+        layoutFlags = flags;
+        return *this;
+    }
+
     LveDescriptorSetLayout::Builder &LveDescriptorSetLayout::Builder::addBinding(
         uint32_t binding,
         VkDescriptorType descriptorType,
         VkShaderStageFlags stageFlags,
-        uint32_t count)
+        uint32_t count,
+        VkDescriptorBindingFlags bindingFlags)
     {
         assert(bindings.count(binding) == 0 && "Binding already in use");
         VkDescriptorSetLayoutBinding layoutBinding{};
@@ -18,28 +54,61 @@ namespace lve
         layoutBinding.descriptorCount = count;
         layoutBinding.stageFlags = stageFlags;
         bindings[binding] = layoutBinding;
+        if (bindingFlags != 0)
+        {
+            this->bindingFlags[binding] = bindingFlags;
+        }
         return *this;
     }
 
     std::unique_ptr<LveDescriptorSetLayout> LveDescriptorSetLayout::Builder::build() const
     {
-        return std::make_unique<LveDescriptorSetLayout>(lveDevice, bindings);
+        return std::make_unique<LveDescriptorSetLayout>(lveDevice, bindings, bindingFlags, layoutFlags);
+    }
+
+    std::shared_ptr<LveDescriptorSetLayout> LveDescriptorSetLayout::Builder::build(LveDescriptorCache &cache) const
+    {
+        return cache.getLayout(bindings, bindingFlags, layoutFlags);
     }
 
     LveDescriptorSetLayout::LveDescriptorSetLayout(
-        LveDevice &lveDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings)
-        : lveDevice{lveDevice}, bindings{bindings}
+        LveDevice &lveDevice,
+        std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+        std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags,
+        VkDescriptorSetLayoutCreateFlags layoutFlags)
+        : lveDevice{lveDevice}, bindings{bindings}, layoutFlags{layoutFlags}
     {
         std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+        std::vector<VkDescriptorBindingFlags> setLayoutBindingFlags{};
+        bool updateAfterBind = false;
         for (auto kv : bindings)
         {
             setLayoutBindings.push_back(kv.second);
+
+            VkDescriptorBindingFlags flags = bindingFlags.count(kv.first) ? bindingFlags[kv.first] : 0;
+            setLayoutBindingFlags.push_back(flags);
+            updateAfterBind |= (flags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT) != 0;
         }
 
         VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
         descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
         descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
         descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
+        descriptorSetLayoutInfo.flags = layoutFlags;
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
+        if (!bindingFlags.empty())
+        {
+            bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+            bindingFlagsInfo.bindingCount = static_cast<uint32_t>(setLayoutBindingFlags.size());
+            bindingFlagsInfo.pBindingFlags = setLayoutBindingFlags.data();
+            descriptorSetLayoutInfo.pNext = &bindingFlagsInfo;
+        }
+        if (updateAfterBind)
+        {
+            // sets of this layout have to come from pools created with the matching flag
+            descriptorSetLayoutInfo.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+        }
 
         if (vkCreateDescriptorSetLayout(
                 lveDevice.device(),
@@ -115,8 +184,7 @@ namespace lve
         allocInfo.pSetLayouts = &descriptorSetLayout;
         allocInfo.descriptorSetCount = 1;
 
-        // Might want to create a "DescriptorPoolManager" class that handles this case, and builds
-        // a new pool whenever an old pool fills up. But this is beyond our current scope
+        // fails once the pool is exhausted, LveDescriptorAllocator chains a new pool in that case
         if (vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &descriptor) != VK_SUCCESS)
         {
             return false;
@@ -138,8 +206,294 @@ namespace lve
         vkResetDescriptorPool(lveDevice.device(), descriptorPool, 0);
     }
 
+    const std::vector<LveDescriptorAllocator::PoolSizeRatio> LveDescriptorAllocator::DEFAULT_POOL_RATIOS = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f},
+    };
+
+    LveDescriptorAllocator::LveDescriptorAllocator(
+        LveDevice &lveDevice, uint32_t setsPerPool, const std::vector<PoolSizeRatio> &poolRatios)
+        : lveDevice{lveDevice}, setsPerPool{std::max(setsPerPool, 1u)}, frameChains(lveDevice.getFramesInFlight())
+    {
+        for (const PoolSizeRatio &poolRatio : poolRatios)
+        {
+            uint32_t count = static_cast<uint32_t>(std::ceil(poolRatio.ratio * this->setsPerPool));
+            this->poolSizes.push_back({poolRatio.descriptorType, std::max(count, 1u)});
+        }
+    }
+
+    LveDescriptorAllocator::~LveDescriptorAllocator() {}
+
+    std::unique_ptr<LveDescriptorPool> LveDescriptorAllocator::acquirePool()
+    {
+        if (!this->freePools.empty())
+        {
+            std::unique_ptr<LveDescriptorPool> pool = std::move(this->freePools.back());
+            this->freePools.pop_back();
+            return pool;
+        }
+
+        return std::make_unique<LveDescriptorPool>(this->lveDevice, this->setsPerPool, 0, this->poolSizes);
+    }
+
+    VkDescriptorSet LveDescriptorAllocator::allocate(PoolChain &chain, VkDescriptorSetLayout descriptorSetLayout)
+    {
+        if (chain.current == nullptr)
+        {
+            chain.current = this->acquirePool();
+        }
+
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        if (chain.current->allocateDescriptor(descriptorSetLayout, set))
+        {
+            return set;
+        }
+
+        // out of pool memory or fragmented, continue in a fresh pool
+        chain.full.push_back(std::move(chain.current));
+        chain.current = this->acquirePool();
+        if (!chain.current->allocateDescriptor(descriptorSetLayout, set))
+        {
+            throw std::runtime_error("failed to allocate descriptor set!");
+        }
+
+        return set;
+    }
+
+    VkDescriptorSet LveDescriptorAllocator::allocate(VkDescriptorSetLayout descriptorSetLayout)
+    {
+        return this->allocate(this->persistentChain, descriptorSetLayout);
+    }
+
+    VkDescriptorSet LveDescriptorAllocator::allocateTransient(int frameIndex, VkDescriptorSetLayout descriptorSetLayout)
+    {
+        return this->allocate(this->frameChains[frameIndex], descriptorSetLayout);
+    }
+
+    void LveDescriptorAllocator::resetFrame(int frameIndex)
+    {
+        PoolChain &chain = this->frameChains[frameIndex];
+        if (chain.current != nullptr)
+        {
+            chain.current->resetPool();
+        }
+
+        for (auto &pool : chain.full)
+        {
+            pool->resetPool();
+            this->freePools.push_back(std::move(pool));
+        }
+        chain.full.clear();
+    }
+
+    size_t LveDescriptorAllocator::getPoolCount() const
+    {
+        size_t count = this->freePools.size() + this->persistentChain.full.size();
+        if (this->persistentChain.current != nullptr) count++;
+        for (const PoolChain &chain : this->frameChains)
+        {
+            count += chain.full.size();
+            if (chain.current != nullptr) count++;
+        }
+
+        return count;
+    }
+
+    LveDescriptorCache::LveDescriptorCache(LveDevice &lveDevice, LveDescriptorAllocator &allocator)
+        : lveDevice{lveDevice}, allocator{allocator}
+    {
+        this->handleListener = lveDevice.addHandleListener([this](uint64_t handle) { this->invalidate(handle); });
+    }
+
+    LveDescriptorCache::~LveDescriptorCache() { this->lveDevice.removeHandleListener(this->handleListener); }
+
+    void LveDescriptorCache::invalidate(uint64_t handle)
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        for (auto it = this->sets.begin(); it != this->sets.end();)
+        {
+            const CachedSet &cachedSet = it->second;
+            if (std::find(cachedSet.handles.begin(), cachedSet.handles.end(), handle) == cachedSet.handles.end())
+            {
+                ++it;
+                continue;
+            }
+
+            // frames in flight may still bind the set
+            std::shared_ptr<FreeSets> freeSets = this->freeSets;
+            VkDescriptorSet set = cachedSet.set;
+            VkDescriptorSetLayout layout = cachedSet.layout;
+            this->lveDevice.deferDestroy([freeSets, set, layout]() {
+                std::lock_guard<std::mutex> lock{freeSets->mutex};
+                freeSets->sets[layout].push_back(set);
+            });
+            it = this->sets.erase(it);
+        }
+    }
+
+    size_t LveDescriptorCache::getSetCount() const
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        return this->sets.size();
+    }
+
+    bool LveDescriptorCache::findSet(const std::string &key, VkDescriptorSet &set) const
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        auto cached = this->sets.find(key);
+        if (cached == this->sets.end())
+        {
+            return false;
+        }
+
+        set = cached->second.set;
+        return true;
+    }
+
+    VkDescriptorSet LveDescriptorCache::allocateSet(VkDescriptorSetLayout layout)
+    {
+        {
+            std::lock_guard<std::mutex> lock{this->freeSets->mutex};
+            auto free = this->freeSets->sets.find(layout);
+            if (free != this->freeSets->sets.end() && !free->second.empty())
+            {
+                VkDescriptorSet set = free->second.back();
+                free->second.pop_back();
+                return set;
+            }
+        }
+
+        return this->allocator.allocate(layout);
+    }
+
+    void LveDescriptorCache::addSet(const std::string &key, const CachedSet &cachedSet)
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        this->sets[key] = cachedSet;
+    }
+
+    std::shared_ptr<LveDescriptorSetLayout> LveDescriptorCache::getLayout(
+        const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> &bindings,
+        const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags,
+        VkDescriptorSetLayoutCreateFlags layoutFlags)
+    {
+        std::string key{};
+        appendKey(key, layoutFlags);
+        for (const VkDescriptorSetLayoutBinding &binding : sortedBindings(bindings))
+        {
+            auto flags = bindingFlags.find(binding.binding);
+            appendKey(key, binding.binding);
+            appendKey(key, binding.descriptorType);
+            appendKey(key, binding.descriptorCount);
+            appendKey(key, binding.stageFlags);
+            appendKey(key, flags != bindingFlags.end() ? flags->second : VkDescriptorBindingFlags{0});
+        }
+
+        auto cached = this->layouts.find(key);
+        if (cached != this->layouts.end())
+        {
+            return cached->second;
+        }
+
+        auto layout = std::make_shared<LveDescriptorSetLayout>(this->lveDevice, bindings, bindingFlags, layoutFlags);
+        this->layouts[key] = layout;
+        return layout;
+    }
+
+    LveDescriptorUpdateTemplate::Builder &LveDescriptorUpdateTemplate::Builder::addEntry(
+        uint32_t binding, size_t offset, size_t stride)
+    {
+        VkDescriptorUpdateTemplateEntry entry{};
+        entry.dstBinding = binding;
+        entry.dstArrayElement = 0;
+        entry.offset = offset;
+        entry.stride = stride;
+        entries.push_back(entry);
+        return *this;
+    }
+
+    std::unique_ptr<LveDescriptorUpdateTemplate> LveDescriptorUpdateTemplate::Builder::build() const
+    {
+        return std::make_unique<LveDescriptorUpdateTemplate>(lveDevice, setLayout, entries);
+    }
+
+    std::unique_ptr<LveDescriptorUpdateTemplate> LveDescriptorUpdateTemplate::Builder::buildPush(
+        VkPipelineLayout pipelineLayout, uint32_t set) const
+    {
+        return std::make_unique<LveDescriptorUpdateTemplate>(lveDevice, setLayout, entries, pipelineLayout, set);
+    }
+
+    LveDescriptorUpdateTemplate::LveDescriptorUpdateTemplate(
+        LveDevice &lveDevice,
+        const LveDescriptorSetLayout &setLayout,
+        std::vector<VkDescriptorUpdateTemplateEntry> entries,
+        VkPipelineLayout pipelineLayout,
+        uint32_t set)
+        : lveDevice{lveDevice}, pipelineLayout{pipelineLayout}, set{set}
+    {
+        for (auto &entry : entries)
+        {
+            assert(setLayout.bindings.count(entry.dstBinding) == 1 && "Layout does not contain specified binding");
+
+            const VkDescriptorSetLayoutBinding &binding = setLayout.bindings.at(entry.dstBinding);
+            entry.descriptorType = binding.descriptorType;
+            entry.descriptorCount = binding.descriptorCount;
+        }
+
+        VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+        templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+        templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+        templateInfo.pDescriptorUpdateEntries = entries.data();
+        templateInfo.descriptorSetLayout = setLayout.getDescriptorSetLayout();
+        if (setLayout.isPushDescriptor())
+        {
+            assert(pipelineLayout != VK_NULL_HANDLE && "Push descriptor templates need a pipeline layout");
+            templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR;
+            templateInfo.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            templateInfo.pipelineLayout = pipelineLayout;
+            templateInfo.set = set;
+        }
+        else
+        {
+            templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+        }
+
+        if (vkCreateDescriptorUpdateTemplate(lveDevice.device(), &templateInfo, nullptr, &updateTemplate) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create descriptor update template!");
+        }
+    }
+
+    LveDescriptorUpdateTemplate::~LveDescriptorUpdateTemplate()
+    {
+        vkDestroyDescriptorUpdateTemplate(lveDevice.device(), updateTemplate, nullptr);
+    }
+
+    void LveDescriptorUpdateTemplate::update(VkDescriptorSet set, const void *data) const
+    {
+        vkUpdateDescriptorSetWithTemplate(lveDevice.device(), set, updateTemplate, data);
+    }
+
+    void LveDescriptorUpdateTemplate::push(VkCommandBuffer commandBuffer, const void *data) const
+    {
+        assert(pipelineLayout != VK_NULL_HANDLE && "Template was not built for push descriptors");
+        lveDevice.pushDescriptor.cmdPushDescriptorSetWithTemplate(commandBuffer, updateTemplate, pipelineLayout, set, data);
+    }
+
+    LveDescriptorWriter::LveDescriptorWriter(LveDescriptorSetLayout &setLayout) : setLayout{setLayout} {}
+
     LveDescriptorWriter::LveDescriptorWriter(LveDescriptorSetLayout &setLayout, LveDescriptorPool &pool)
-        : setLayout{setLayout}, pool{pool} {}
+        : setLayout{setLayout}, pool{&pool} {}
+
+    LveDescriptorWriter::LveDescriptorWriter(LveDescriptorSetLayout &setLayout, LveDescriptorAllocator &allocator)
+        : setLayout{setLayout}, allocator{&allocator} {}
+
+    LveDescriptorWriter::LveDescriptorWriter(LveDescriptorSetLayout &setLayout, LveDescriptorCache &cache)
+        : setLayout{setLayout}, allocator{&cache.allocator}, cache{&cache} {}
 
     LveDescriptorWriter &LveDescriptorWriter::writeBuffer(
         uint32_t binding, VkDescriptorBufferInfo *bufferInfo)
@@ -187,12 +541,99 @@ namespace lve
 
     bool LveDescriptorWriter::build(VkDescriptorSet &set)
     {
-        bool success = pool.allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
-        if (!success)
+        std::string key{};
+        if (cache != nullptr)
+        {
+            key = setKey();
+            if (cache->findSet(key, set))
+            {
+                return true;
+            }
+
+            set = cache->allocateSet(setLayout.getDescriptorSetLayout());
+        }
+        else if (allocator != nullptr)
+        {
+            set = allocator->allocate(setLayout.getDescriptorSetLayout());
+        }
+        else if (!pool->allocateDescriptor(setLayout.getDescriptorSetLayout(), set))
         {
             return false;
         }
         overwrite(set);
+
+        if (cache != nullptr)
+        {
+            cache->addSet(key, {set, setLayout.getDescriptorSetLayout(), resourceHandles()});
+        }
+        return true;
+    }
+
+    std::vector<uint64_t> LveDescriptorWriter::resourceHandles() const
+    {
+        std::vector<uint64_t> handles{};
+        for (const auto &write : writes)
+        {
+            if (write.pBufferInfo != nullptr)
+            {
+                handles.push_back(reinterpret_cast<uint64_t>(write.pBufferInfo->buffer));
+            }
+            if (write.pImageInfo != nullptr)
+            {
+                if (write.pImageInfo->imageView != VK_NULL_HANDLE)
+                {
+                    handles.push_back(reinterpret_cast<uint64_t>(write.pImageInfo->imageView));
+                }
+                if (write.pImageInfo->sampler != VK_NULL_HANDLE)
+                {
+                    handles.push_back(reinterpret_cast<uint64_t>(write.pImageInfo->sampler));
+                }
+            }
+        }
+
+        return handles;
+    }
+
+    std::string LveDescriptorWriter::setKey() const
+    {
+        std::vector<const VkWriteDescriptorSet *> sortedWrites{};
+        for (const auto &write : writes)
+        {
+            sortedWrites.push_back(&write);
+        }
+        std::stable_sort(sortedWrites.begin(), sortedWrites.end(), [](const auto *a, const auto *b) {
+            return a->dstBinding < b->dstBinding;
+        });
+
+        std::string key{};
+        appendKey(key, setLayout.getDescriptorSetLayout());
+        for (const VkWriteDescriptorSet *write : sortedWrites)
+        {
+            appendKey(key, write->dstBinding);
+            appendKey(key, write->descriptorType);
+            if (write->pBufferInfo != nullptr)
+            {
+                appendKey(key, write->pBufferInfo->buffer);
+                appendKey(key, write->pBufferInfo->offset);
+                appendKey(key, write->pBufferInfo->range);
+            }
+            if (write->pImageInfo != nullptr)
+            {
+                appendKey(key, write->pImageInfo->sampler);
+                appendKey(key, write->pImageInfo->imageView);
+                appendKey(key, write->pImageInfo->imageLayout);
+            }
+        }
+
+        return key;
+    }
+
+    bool LveDescriptorWriter::buildTransient(int frameIndex, VkDescriptorSet &set)
+    {
+        assert(allocator != nullptr && "Transient descriptor sets need an allocator");
+
+        set = allocator->allocateTransient(frameIndex, setLayout.getDescriptorSetLayout());
+        overwrite(set);
         return true;
     }
 
@@ -202,6 +643,18 @@ namespace lve
         {
             write.dstSet = set;
         }
-        vkUpdateDescriptorSets(pool.lveDevice.device(), writes.size(), writes.data(), 0, nullptr);
+        vkUpdateDescriptorSets(setLayout.lveDevice.device(), writes.size(), writes.data(), 0, nullptr);
+    }
+
+    void LveDescriptorWriter::push(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t set)
+    {
+        assert(setLayout.isPushDescriptor() && "Layout was not built for push descriptors");
+        setLayout.lveDevice.pushDescriptor.cmdPushDescriptorSet(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            set,
+            static_cast<uint32_t>(writes.size()),
+            writes.data());
     }
 }
@@ -3,11 +3,15 @@
 #include "lve_device.hpp"
 
 #include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace lve
 {
+    class LveDescriptorCache;
+
     class LveDescriptorSetLayout
     {
     public:
@@ -16,32 +20,50 @@ namespace lve
         public:
             Builder(LveDevice &lveDevice) : lveDevice{lveDevice} {}
 
+            // bindingFlags are VkDescriptorBindingFlagBitsEXT, needs VK_EXT_descriptor_indexing
             Builder &addBinding(
                 uint32_t binding,
                 VkDescriptorType descriptorType,
                 VkShaderStageFlags stageFlags,
-                uint32_t count = 1);
+                uint32_t count = 1,
+                VkDescriptorBindingFlags bindingFlags = 0);
             std::unique_ptr<LveDescriptorSetLayout> build() const;
+            // shares the layout with every other layout built from the same bindings
+            std::shared_ptr<LveDescriptorSetLayout> build(LveDescriptorCache &cache) const;
+            // e.g. VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR
+            Builder &setLayoutFlags(VkDescriptorSetLayoutCreateFlags flags);
 
         private:
             LveDevice &lveDevice;
             std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+            std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags{};
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0;
         };
 
         LveDescriptorSetLayout(
-            LveDevice &lveDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+            LveDevice &lveDevice,
+            std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+            std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags = {},
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0);
         ~LveDescriptorSetLayout();
         LveDescriptorSetLayout(const LveDescriptorSetLayout &) = delete;
         LveDescriptorSetLayout &operator=(const LveDescriptorSetLayout &) = delete;
 
         VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+        bool isPushDescriptor() const
+        {
+            return (layoutFlags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR) != 0;
+        }
 
     private:
         LveDevice &lveDevice;
         VkDescriptorSetLayout descriptorSetLayout;
         std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings;
+        VkDescriptorSetLayoutCreateFlags layoutFlags;
 
         friend class LveDescriptorWriter;
+        friend class LveDescriptorCache;
+        friend class LveDescriptorUpdateTemplate;
     };
 
     class LveDescriptorPool
@@ -87,20 +109,190 @@ namespace lve
         friend class LveDescriptorWriter;
     };
 
+    // Hands out descriptor sets from chains of pools that grow on demand. Persistent sets live
+    // as long as the allocator; transient sets come from per-frame pools that are reset wholesale
+    // once the frame finished on the device, so allocating them every frame costs next to nothing.
+    // Pools that filled up are reset and recycled instead of being destroyed.
+    class LveDescriptorAllocator
+    {
+    public:
+        static constexpr uint32_t DEFAULT_SETS_PER_POOL = 256;
+
+        // number of descriptors of a type reserved per set in each pool
+        struct PoolSizeRatio
+        {
+            VkDescriptorType descriptorType;
+            float ratio;
+        };
+
+        static const std::vector<PoolSizeRatio> DEFAULT_POOL_RATIOS;
+
+        LveDescriptorAllocator(
+            LveDevice &lveDevice,
+            uint32_t setsPerPool = DEFAULT_SETS_PER_POOL,
+            const std::vector<PoolSizeRatio> &poolRatios = DEFAULT_POOL_RATIOS);
+        ~LveDescriptorAllocator();
+        LveDescriptorAllocator(const LveDescriptorAllocator &) = delete;
+        LveDescriptorAllocator &operator=(const LveDescriptorAllocator &) = delete;
+
+        VkDescriptorSet allocate(VkDescriptorSetLayout descriptorSetLayout);
+        // the set stays valid until resetFrame is called for the same frame index
+        VkDescriptorSet allocateTransient(int frameIndex, VkDescriptorSetLayout descriptorSetLayout);
+
+        // Call after waiting for the frame to finish, before allocating transient sets for it
+        void resetFrame(int frameIndex);
+
+        size_t getPoolCount() const;
+
+    private:
+        struct PoolChain
+        {
+            std::unique_ptr<LveDescriptorPool> current{};
+            std::vector<std::unique_ptr<LveDescriptorPool>> full{};
+        };
+
+        VkDescriptorSet allocate(PoolChain &chain, VkDescriptorSetLayout descriptorSetLayout);
+        std::unique_ptr<LveDescriptorPool> acquirePool();
+
+        LveDevice &lveDevice;
+        uint32_t setsPerPool;
+        std::vector<VkDescriptorPoolSize> poolSizes{};
+
+        PoolChain persistentChain{};
+        std::vector<PoolChain> frameChains;
+        std::vector<std::unique_ptr<LveDescriptorPool>> freePools{};
+    };
+
+    // Shares descriptor set layouts with identical bindings and descriptor sets with identical
+    // contents. Cached sets come from the allocator's persistent pools. A set is dropped from the
+    // cache once a resource it references reports its handle destroyed to the device, and reused
+    // for another set of the same layout after the frames in flight finished with it.
+    class LveDescriptorCache
+    {
+    public:
+        LveDescriptorCache(LveDevice &lveDevice, LveDescriptorAllocator &allocator);
+        ~LveDescriptorCache();
+        LveDescriptorCache(const LveDescriptorCache &) = delete;
+        LveDescriptorCache &operator=(const LveDescriptorCache &) = delete;
+
+        std::shared_ptr<LveDescriptorSetLayout> getLayout(
+            const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> &bindings,
+            const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags = {},
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0);
+
+        // drops every cached set referencing handle, called through LveDevice::releaseHandle
+        void invalidate(uint64_t handle);
+
+        size_t getLayoutCount() const { return layouts.size(); }
+        size_t getSetCount() const;
+
+    private:
+        struct CachedSet
+        {
+            VkDescriptorSet set;
+            VkDescriptorSetLayout layout;
+            std::vector<uint64_t> handles;
+        };
+        // shared with the deferred destructions returning sets, which may run after the cache
+        // was destroyed
+        struct FreeSets
+        {
+            std::mutex mutex;
+            std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>> sets{};
+        };
+
+        bool findSet(const std::string &key, VkDescriptorSet &set) const;
+        VkDescriptorSet allocateSet(VkDescriptorSetLayout layout);
+        void addSet(const std::string &key, const CachedSet &cachedSet);
+
+        LveDevice &lveDevice;
+        LveDescriptorAllocator &allocator;
+        std::unordered_map<std::string, std::shared_ptr<LveDescriptorSetLayout>> layouts{};
+        // resources may be destroyed on any thread, invalidate only touches sets and freeSets
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, CachedSet> sets{};
+        std::shared_ptr<FreeSets> freeSets = std::make_shared<FreeSets>();
+        uint64_t handleListener;
+
+        friend class LveDescriptorWriter;
+    };
+
+    // Writes every descriptor of a set from one packed struct in a single call, without building
+    // VkWriteDescriptorSet vectors or looking up bindings. Build it once per layout and reuse it
+    // for sets that are updated often.
+    class LveDescriptorUpdateTemplate
+    {
+    public:
+        class Builder
+        {
+        public:
+            Builder(LveDevice &lveDevice, LveDescriptorSetLayout &setLayout)
+                : lveDevice{lveDevice}, setLayout{setLayout} {}
+
+            // offset of the binding's VkDescriptorBufferInfo/VkDescriptorImageInfo in the packed
+            // struct, stride separates the elements of array bindings
+            Builder &addEntry(uint32_t binding, size_t offset, size_t stride = 0);
+            std::unique_ptr<LveDescriptorUpdateTemplate> build() const;
+            // for push descriptor layouts, pushes to set of pipelineLayout
+            std::unique_ptr<LveDescriptorUpdateTemplate> buildPush(VkPipelineLayout pipelineLayout, uint32_t set) const;
+
+        private:
+            LveDevice &lveDevice;
+            LveDescriptorSetLayout &setLayout;
+            std::vector<VkDescriptorUpdateTemplateEntry> entries{};
+        };
+
+        LveDescriptorUpdateTemplate(
+            LveDevice &lveDevice,
+            const LveDescriptorSetLayout &setLayout,
+            std::vector<VkDescriptorUpdateTemplateEntry> entries,
+            VkPipelineLayout pipelineLayout = VK_NULL_HANDLE,
+            uint32_t set = 0);
+        ~LveDescriptorUpdateTemplate();
+        LveDescriptorUpdateTemplate(const LveDescriptorUpdateTemplate &) = delete;
+        LveDescriptorUpdateTemplate &operator=(const LveDescriptorUpdateTemplate &) = delete;
+
+        void update(VkDescriptorSet set, const void *data) const;
+        // records the descriptors into the command buffer, needs VK_KHR_push_descriptor
+        void push(VkCommandBuffer commandBuffer, const void *data) const;
+
+    private:
+        LveDevice &lveDevice;
+        VkDescriptorUpdateTemplate updateTemplate;
+        VkPipelineLayout pipelineLayout;
+        uint32_t set;
+    };
+
     class LveDescriptorWriter
     {
     public:
+        // only for push, which needs no pool
+        LveDescriptorWriter(LveDescriptorSetLayout &setLayout);
         LveDescriptorWriter(LveDescriptorSetLayout &setLayout, LveDescriptorPool &pool);
+        LveDescriptorWriter(LveDescriptorSetLayout &setLayout, LveDescriptorAllocator &allocator);
+        // build returns the cached set when one with the same layout and resources was built before
+        LveDescriptorWriter(LveDescriptorSetLayout &setLayout, LveDescriptorCache &cache);
 
         LveDescriptorWriter &writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo);
         LveDescriptorWriter &writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo);
 
         bool build(VkDescriptorSet &set);
+        // allocates from the allocator's pools of frameIndex, see LveDescriptorAllocator
+        bool buildTransient(int frameIndex, VkDescriptorSet &set);
         void overwrite(VkDescriptorSet &set);
+        // records the writes into the command buffer instead of a set, needs a push descriptor
+        // layout and VK_KHR_push_descriptor
+        void push(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t set);
 
     private:
+        std::string setKey() const;
+        // buffers, image views and samplers the writes reference
+        std::vector<uint64_t> resourceHandles() const;
+
         LveDescriptorSetLayout &setLayout;
-        LveDescriptorPool &pool;
+        LveDescriptorPool *pool = nullptr;
+        LveDescriptorAllocator *allocator = nullptr;
+        LveDescriptorCache *cache = nullptr;
         std::vector<VkWriteDescriptorSet> writes;
     };
 }
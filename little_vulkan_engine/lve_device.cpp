@@ -1,8 +1,14 @@
 #include "lve_device.hpp"
 
 // std headers
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <set>
 #include <unordered_set>
 
@@ -53,20 +59,61 @@ namespace lve
         }
     }
 
+    FrameConfig FrameConfig::lowLatency()
+    {
+        FrameConfig config{};
+        config.framesInFlight = 1;
+        config.extraSwapChainImages = 0;
+        config.presentModes = {VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+        return config;
+    }
+
+    FrameConfig FrameConfig::throughput()
+    {
+        FrameConfig config{};
+        config.framesInFlight = 3;
+        config.extraSwapChainImages = 2;
+        config.presentThread = true;
+        config.presentModes = {VK_PRESENT_MODE_MAILBOX_KHR};
+        return config;
+    }
+
     // class member functions
-    LveDevice::LveDevice(LveWindow &window) : window{window}
+    LveDevice::LveDevice(LveWindow &window, const FrameConfig &frameConfig)
+        : window{window}, frameConfig{frameConfig}
     {
+        assert(frameConfig.framesInFlight > 0 && "At least one frame has to be in flight");
+
         createInstance();
         setupDebugMessenger();
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
         createCommandPool();
+        createPipelineCache();
+        createTimelineSemaphore();
     }
 
     LveDevice::~LveDevice()
     {
+        vkDeviceWaitIdle(device_);
+        while (!deletionQueue.empty())
+        {
+            completeFrames(std::numeric_limits<uint64_t>::max());
+        }
+
+        vkDestroySemaphore(device_, timelineSemaphore_, nullptr);
+        savePipelineCache();
+        vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
         vkDestroyCommandPool(device_, commandPool, nullptr);
+        {
+            std::lock_guard<std::mutex> lock{threadCommandPools->mutex};
+            for (VkCommandPool pool : threadCommandPools->pools)
+            {
+                vkDestroyCommandPool(device_, pool, nullptr);
+            }
+            threadCommandPools->destroyed = true;
+        }
         vkDestroyDevice(device_, nullptr);
 
         if (enableValidationLayers)
@@ -78,6 +125,55 @@ namespace lve
         vkDestroyInstance(instance, nullptr);
     }
 
+    void LveDevice::deferDestroy(std::function<void()> destroy)
+    {
+        std::lock_guard<std::mutex> lock{this->deletionMutex};
+        this->deletionQueue.push_back({std::move(destroy), this->currentFrame});
+    }
+
+    void LveDevice::completeFrames(uint64_t completedFrame)
+    {
+        std::vector<DeferredDestroy> ready{};
+        {
+            std::lock_guard<std::mutex> lock{this->deletionMutex};
+            auto pending = std::stable_partition(
+                this->deletionQueue.begin(),
+                this->deletionQueue.end(),
+                [&](const DeferredDestroy &entry) { return entry.frame >= completedFrame; });
+            std::move(pending, this->deletionQueue.end(), std::back_inserter(ready));
+            this->deletionQueue.erase(pending, this->deletionQueue.end());
+        }
+
+        // outside the lock, destroying one object may defer the destruction of others
+        for (DeferredDestroy &entry : ready)
+        {
+            entry.destroy();
+        }
+    }
+
+    uint64_t LveDevice::addHandleListener(HandleListener listener)
+    {
+        std::lock_guard<std::mutex> lock{this->listenerMutex};
+        uint64_t id = this->nextListenerId++;
+        this->handleListeners[id] = std::move(listener);
+        return id;
+    }
+
+    void LveDevice::removeHandleListener(uint64_t id)
+    {
+        std::lock_guard<std::mutex> lock{this->listenerMutex};
+        this->handleListeners.erase(id);
+    }
+
+    void LveDevice::releaseHandle(uint64_t handle)
+    {
+        std::lock_guard<std::mutex> lock{this->listenerMutex};
+        for (auto &kv : this->handleListeners)
+        {
+            kv.second(handle);
+        }
+    }
+
     void LveDevice::createInstance()
     {
         if (enableValidationLayers && !checkValidationLayerSupport())
@@ -91,7 +187,8 @@ namespace lve
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        // 1.2 for timeline semaphores, vkGetPhysicalDeviceFeatures2 queries optional extension features
+        appInfo.apiVersion = VK_API_VERSION_1_2;
 
         VkInstanceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -171,18 +268,165 @@ namespace lve
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        std::vector<const char *> enabledExtensions = deviceExtensions;
+        bool hasExtendedDynamicState =
+            isDeviceExtensionAvailable(physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+        bool hasExtendedDynamicState3 =
+            isDeviceExtensionAvailable(physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+        // VK_KHR_dynamic_rendering depends on these two on a 1.1 instance
+        bool hasDynamicRendering =
+            isDeviceExtensionAvailable(physicalDevice, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) &&
+            isDeviceExtensionAvailable(physicalDevice, VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME) &&
+            isDeviceExtensionAvailable(physicalDevice, VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME);
+        bool hasPushDescriptor =
+            isDeviceExtensionAvailable(physicalDevice, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+        bool hasDescriptorIndexing =
+            isDeviceExtensionAvailable(physicalDevice, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+
+        // only chain feature structs of extensions the device knows about
+        VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures = {};
+        extendedDynamicStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+        VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3Features = {};
+        extendedDynamicState3Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures = {};
+        descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {};
+        dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+        VkPhysicalDeviceFeatures2 supportedFeatures2 = {};
+        supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        void **next = &supportedFeatures2.pNext;
+        if (hasExtendedDynamicState)
+        {
+            *next = &extendedDynamicStateFeatures;
+            next = &extendedDynamicStateFeatures.pNext;
+        }
+        if (hasExtendedDynamicState3)
+        {
+            *next = &extendedDynamicState3Features;
+            next = &extendedDynamicState3Features.pNext;
+        }
+        if (hasDescriptorIndexing)
+        {
+            *next = &descriptorIndexingFeatures;
+            next = &descriptorIndexingFeatures.pNext;
+        }
+        if (hasDynamicRendering)
+        {
+            *next = &dynamicRenderingFeatures;
+            next = &dynamicRenderingFeatures.pNext;
+        }
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+        const VkPhysicalDeviceFeatures &supportedFeatures = supportedFeatures2.features;
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        // optional, lets the render system draw the whole geometry pool with one indirect call
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        // optional, wireframe debug rendering
+        deviceFeatures.fillModeNonSolid = supportedFeatures.fillModeNonSolid;
+        this->enabledFeatures = deviceFeatures;
+
+        // the same structs, trimmed to what is used, now enable the features
+        VkPhysicalDeviceFeatures2 enabledFeatures2 = {};
+        enabledFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        enabledFeatures2.features = deviceFeatures;
+        next = &enabledFeatures2.pNext;
+        extendedDynamicStateFeatures.pNext = nullptr;
+        extendedDynamicState3Features.pNext = nullptr;
+        descriptorIndexingFeatures.pNext = nullptr;
+        dynamicRenderingFeatures.pNext = nullptr;
+
+        // required, isDeviceSuitable checked it
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = {};
+        timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+        *next = &timelineSemaphoreFeatures;
+        next = &timelineSemaphoreFeatures.pNext;
+
+        this->extendedDynamicState.supported =
+            hasExtendedDynamicState && extendedDynamicStateFeatures.extendedDynamicState;
+        if (this->extendedDynamicState.supported)
+        {
+            enabledExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+            *next = &extendedDynamicStateFeatures;
+            next = &extendedDynamicStateFeatures.pNext;
+        }
+
+        this->extendedDynamicState.supported3 =
+            hasExtendedDynamicState3 &&
+            extendedDynamicState3Features.extendedDynamicState3PolygonMode &&
+            extendedDynamicState3Features.extendedDynamicState3ColorBlendEnable &&
+            extendedDynamicState3Features.extendedDynamicState3ColorWriteMask;
+        if (this->extendedDynamicState.supported3)
+        {
+            VkPhysicalDeviceExtendedDynamicState3FeaturesEXT used = {};
+            used.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+            used.extendedDynamicState3PolygonMode = VK_TRUE;
+            used.extendedDynamicState3ColorBlendEnable = VK_TRUE;
+            used.extendedDynamicState3ColorWriteMask = VK_TRUE;
+            extendedDynamicState3Features = used;
+
+            enabledExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+            *next = &extendedDynamicState3Features;
+            next = &extendedDynamicState3Features.pNext;
+        }
+
+        this->descriptorIndexing.supported =
+            hasDescriptorIndexing &&
+            descriptorIndexingFeatures.runtimeDescriptorArray &&
+            descriptorIndexingFeatures.descriptorBindingPartiallyBound &&
+            descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending &&
+            descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind &&
+            descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+            descriptorIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing &&
+            descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing;
+        if (this->descriptorIndexing.supported)
+        {
+            VkPhysicalDeviceDescriptorIndexingFeaturesEXT used = {};
+            used.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+            used.runtimeDescriptorArray = VK_TRUE;
+            used.descriptorBindingPartiallyBound = VK_TRUE;
+            used.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+            used.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+            used.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            used.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+            used.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+            descriptorIndexingFeatures = used;
+
+            enabledExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+            *next = &descriptorIndexingFeatures;
+            next = &descriptorIndexingFeatures.pNext;
+        }
+
+        this->dynamicRendering.supported = hasDynamicRendering && dynamicRenderingFeatures.dynamicRendering;
+        if (this->dynamicRendering.supported)
+        {
+            enabledExtensions.push_back(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME);
+            enabledExtensions.push_back(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME);
+            enabledExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+            *next = &dynamicRenderingFeatures;
+            next = &dynamicRenderingFeatures.pNext;
+        }
+
+        // no feature struct, the extension alone enables it
+        this->pushDescriptor.supported = hasPushDescriptor;
+        if (this->pushDescriptor.supported)
+        {
+            enabledExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+        }
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = &enabledFeatures2;
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-        createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.pEnabledFeatures = nullptr;
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -200,12 +444,95 @@ namespace lve
         {
             throw std::runtime_error("failed to create logical device!");
         }
+        threadCommandPools->device = device_;
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+        loadExtendedDynamicState();
+        loadPushDescriptor();
+        loadDynamicRendering();
+        queryDescriptorIndexingLimits();
+    }
+
+    void LveDevice::loadPushDescriptor()
+    {
+        PushDescriptor &push = this->pushDescriptor;
+        if (push.supported)
+        {
+            push.cmdPushDescriptorSet =
+                (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(device_, "vkCmdPushDescriptorSetKHR");
+            push.cmdPushDescriptorSetWithTemplate = (PFN_vkCmdPushDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(
+                device_, "vkCmdPushDescriptorSetWithTemplateKHR");
+        }
+    }
+
+    void LveDevice::loadDynamicRendering()
+    {
+        DynamicRendering &rendering = this->dynamicRendering;
+        if (rendering.supported)
+        {
+            rendering.cmdBeginRendering =
+                (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(device_, "vkCmdBeginRenderingKHR");
+            rendering.cmdEndRendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(device_, "vkCmdEndRenderingKHR");
+        }
+    }
+
+    void LveDevice::queryDescriptorIndexingLimits()
+    {
+        if (!this->descriptorIndexing.supported)
+        {
+            return;
+        }
+
+        VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties = {};
+        indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2 properties2 = {};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &indexingProperties;
+        vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+        // the table is visible to all graphics stages, so the per stage limits apply as well
+        this->descriptorIndexing.maxStorageBuffers = std::min(
+            indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+            indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers);
+        this->descriptorIndexing.maxSampledImages = std::min(
+            indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+            indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+        this->descriptorIndexing.maxSamplers = std::min(
+            indexingProperties.maxDescriptorSetUpdateAfterBindSamplers,
+            indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers);
+    }
+
+    void LveDevice::loadExtendedDynamicState()
+    {
+        ExtendedDynamicState &eds = this->extendedDynamicState;
+        if (eds.supported)
+        {
+            eds.cmdSetCullMode = (PFN_vkCmdSetCullModeEXT)vkGetDeviceProcAddr(device_, "vkCmdSetCullModeEXT");
+            eds.cmdSetFrontFace = (PFN_vkCmdSetFrontFaceEXT)vkGetDeviceProcAddr(device_, "vkCmdSetFrontFaceEXT");
+            eds.cmdSetPrimitiveTopology =
+                (PFN_vkCmdSetPrimitiveTopologyEXT)vkGetDeviceProcAddr(device_, "vkCmdSetPrimitiveTopologyEXT");
+            eds.cmdSetDepthTestEnable =
+                (PFN_vkCmdSetDepthTestEnableEXT)vkGetDeviceProcAddr(device_, "vkCmdSetDepthTestEnableEXT");
+            eds.cmdSetDepthWriteEnable =
+                (PFN_vkCmdSetDepthWriteEnableEXT)vkGetDeviceProcAddr(device_, "vkCmdSetDepthWriteEnableEXT");
+            eds.cmdSetDepthCompareOp =
+                (PFN_vkCmdSetDepthCompareOpEXT)vkGetDeviceProcAddr(device_, "vkCmdSetDepthCompareOpEXT");
+        }
+        if (eds.supported3)
+        {
+            eds.cmdSetPolygonMode = (PFN_vkCmdSetPolygonModeEXT)vkGetDeviceProcAddr(device_, "vkCmdSetPolygonModeEXT");
+            eds.cmdSetColorBlendEnable =
+                (PFN_vkCmdSetColorBlendEnableEXT)vkGetDeviceProcAddr(device_, "vkCmdSetColorBlendEnableEXT");
+            eds.cmdSetColorWriteMask =
+                (PFN_vkCmdSetColorWriteMaskEXT)vkGetDeviceProcAddr(device_, "vkCmdSetColorWriteMaskEXT");
+        }
     }
 
-    void LveDevice::createCommandPool()
+    void LveDevice::createCommandPool() { commandPool = createGraphicsCommandPool(); }
+
+    VkCommandPool LveDevice::createGraphicsCommandPool()
     {
         QueueFamilyIndices queueFamilyIndices = findPhysicalQueueFamilies();
 
@@ -215,10 +542,228 @@ namespace lve
         poolInfo.flags =
             VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-        if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        VkCommandPool pool;
+        if (vkCreateCommandPool(device_, &poolInfo, nullptr, &pool) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create command pool!");
         }
+
+        return pool;
+    }
+
+    VkCommandPool LveDevice::getThreadCommandPool()
+    {
+        // destroyed with the thread, which hands every pool it holds back to its device
+        thread_local std::vector<std::unique_ptr<ThreadCommandPoolLease>> leases{};
+        for (const auto &lease : leases)
+        {
+            if (lease->owner == this->threadCommandPools)
+            {
+                return lease->pool;
+            }
+        }
+
+        VkCommandPool pool = VK_NULL_HANDLE;
+        {
+            std::lock_guard<std::mutex> lock{this->threadCommandPools->mutex};
+            if (!this->threadCommandPools->freePools.empty())
+            {
+                pool = this->threadCommandPools->freePools.back();
+                this->threadCommandPools->freePools.pop_back();
+            }
+        }
+
+        if (pool == VK_NULL_HANDLE)
+        {
+            pool = this->createGraphicsCommandPool();
+            std::lock_guard<std::mutex> lock{this->threadCommandPools->mutex};
+            this->threadCommandPools->pools.push_back(pool);
+        }
+
+        leases.push_back(std::unique_ptr<ThreadCommandPoolLease>{new ThreadCommandPoolLease{this->threadCommandPools, pool}});
+        return pool;
+    }
+
+    LveDevice::ThreadCommandPoolLease::~ThreadCommandPoolLease()
+    {
+        std::lock_guard<std::mutex> lock{this->owner->mutex};
+        if (this->owner->destroyed)
+        {
+            return;
+        }
+
+        // the next thread gets the pool without anything this one left behind
+        vkResetCommandPool(this->owner->device, this->pool, VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT);
+        this->owner->freePools.push_back(this->pool);
+    }
+
+    std::vector<char> LveDevice::readPipelineCacheFile()
+    {
+        std::ifstream file(PIPELINE_CACHE_FILE, std::ios::ate | std::ios::binary);
+        if (!file.is_open())
+        {
+            return {};
+        }
+
+        std::vector<char> data(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(data.data(), data.size());
+
+        // header version one: length, version, vendor id, device id and cache uuid
+        const size_t headerSize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+        if (!file || data.size() < headerSize)
+        {
+            return {};
+        }
+
+        uint32_t header[4];
+        std::memcpy(header, data.data(), sizeof(header));
+        bool matches = header[0] >= headerSize &&
+                       header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                       header[2] == properties.vendorID &&
+                       header[3] == properties.deviceID &&
+                       std::memcmp(data.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        if (!matches)
+        {
+            std::cout << "pipeline cache " << PIPELINE_CACHE_FILE << " is from another device or driver, ignoring it" << std::endl;
+            return {};
+        }
+
+        return data;
+    }
+
+    void LveDevice::createPipelineCache()
+    {
+        std::vector<char> initialData = readPipelineCacheFile();
+
+        VkPipelineCacheCreateInfo cacheInfo = {};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = initialData.size();
+        cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+        if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+        pipelineCacheWarm = !initialData.empty();
+    }
+
+    void LveDevice::savePipelineCache()
+    {
+        size_t size = 0;
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &size, nullptr) != VK_SUCCESS || size == 0)
+        {
+            return;
+        }
+        std::vector<char> data(size);
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &size, data.data()) != VK_SUCCESS)
+        {
+            return;
+        }
+
+        // write next to the old file and rename over it, so a crash never leaves a torn cache
+        std::string tempPath = std::string(PIPELINE_CACHE_FILE) + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(data.data(), size);
+            if (!file)
+            {
+                std::cerr << "failed to write pipeline cache " << tempPath << std::endl;
+                return;
+            }
+        }
+
+        if (std::rename(tempPath.c_str(), PIPELINE_CACHE_FILE) != 0)
+        {
+            std::cerr << "failed to replace pipeline cache " << PIPELINE_CACHE_FILE << std::endl;
+            std::remove(tempPath.c_str());
+        }
+    }
+
+    void LveDevice::createTimelineSemaphore()
+    {
+        VkSemaphoreTypeCreateInfo typeInfo = {};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+
+        if (vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &timelineSemaphore_) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create timeline semaphore!");
+        }
+    }
+
+    uint64_t LveDevice::submit(const VkSubmitInfo &submitInfo)
+    {
+        assert(submitInfo.pNext == nullptr && "submit chains its own VkTimelineSemaphoreSubmitInfo");
+
+        std::vector<VkSemaphore> signalSemaphores(
+            submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+        signalSemaphores.push_back(timelineSemaphore_);
+        // binary semaphores ignore their values, the arrays only have to line up
+        std::vector<uint64_t> waitValues(submitInfo.waitSemaphoreCount, 0);
+        std::vector<uint64_t> signalValues(signalSemaphores.size(), 0);
+
+        std::lock_guard<std::mutex> lock{queueMutex};
+        uint64_t value = timelineValue + 1;
+        signalValues.back() = value;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+        timelineInfo.pWaitSemaphoreValues = waitValues.data();
+        timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+        timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+        VkSubmitInfo timelineSubmitInfo = submitInfo;
+        timelineSubmitInfo.pNext = &timelineInfo;
+        timelineSubmitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+        timelineSubmitInfo.pSignalSemaphores = signalSemaphores.data();
+
+        if (vkQueueSubmit(graphicsQueue_, 1, &timelineSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit to the graphics queue!");
+        }
+
+        timelineValue = value;
+        return value;
+    }
+
+    VkResult LveDevice::present(const VkPresentInfoKHR &presentInfo)
+    {
+        std::lock_guard<std::mutex> lock{queueMutex};
+        return vkQueuePresentKHR(presentQueue_, &presentInfo);
+    }
+
+    void LveDevice::waitIdle()
+    {
+        std::lock_guard<std::mutex> lock{queueMutex};
+        vkDeviceWaitIdle(device_);
+    }
+
+    void LveDevice::waitForTimeline(uint64_t value)
+    {
+        VkSemaphoreWaitInfo waitInfo = {};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &timelineSemaphore_;
+        waitInfo.pValues = &value;
+
+        if (vkWaitSemaphores(device_, &waitInfo, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to wait for the timeline semaphore!");
+        }
+    }
+
+    uint64_t LveDevice::getCompletedTimelineValue()
+    {
+        uint64_t value = 0;
+        vkGetSemaphoreCounterValue(device_, timelineSemaphore_, &value);
+        return value;
     }
 
     void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
@@ -236,11 +781,20 @@ namespace lve
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
 
-        VkPhysicalDeviceFeatures supportedFeatures;
-        vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+        // frames and uploads are synchronized with a timeline semaphore, core since 1.2
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(device, &deviceProperties);
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = {};
+        timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        VkPhysicalDeviceFeatures2 supportedFeatures2 = {};
+        supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures2.pNext = &timelineSemaphoreFeatures;
+        vkGetPhysicalDeviceFeatures2(device, &supportedFeatures2);
 
         return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-               supportedFeatures.samplerAnisotropy;
+               supportedFeatures2.features.samplerAnisotropy &&
+               deviceProperties.apiVersion >= VK_API_VERSION_1_2 &&
+               timelineSemaphoreFeatures.timelineSemaphore;
     }
 
     void LveDevice::populateDebugMessengerCreateInfo(
@@ -364,6 +918,29 @@ namespace lve
         return requiredExtensions.empty();
     }
 
+    bool LveDevice::isDeviceExtensionAvailable(VkPhysicalDevice device, const char *extensionName)
+    {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(
+            device,
+            nullptr,
+            &extensionCount,
+            availableExtensions.data());
+
+        for (const auto &extension : availableExtensions)
+        {
+            if (std::strcmp(extension.extensionName, extensionName) == 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device)
     {
         QueueFamilyIndices indices;
@@ -505,7 +1082,7 @@ namespace lve
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = commandPool;
+        allocInfo.commandPool = this->getThreadCommandPool();
         allocInfo.commandBufferCount = 1;
 
         VkCommandBuffer commandBuffer;
@@ -528,10 +1105,11 @@ namespace lve
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
-        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue_);
+        // waits for this submission only, not for frames still in flight
+        this->waitForTimeline(this->submit(submitInfo));
 
-        vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+        // begin and end run on the same thread, so this is the pool the buffer came from
+        vkFreeCommandBuffers(device_, this->getThreadCommandPool(), 1, &commandBuffer);
     }
 
     void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
@@ -3,7 +3,12 @@
 #include "lve_window.hpp"
 
 // std lib headers
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace lve
@@ -25,6 +30,73 @@ namespace lve
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
+    // Optional VK_EXT_extended_dynamic_state and VK_EXT_extended_dynamic_state3 support. The
+    // command functions are loaded from the device and stay null when unsupported.
+    struct ExtendedDynamicState
+    {
+        // cull mode, front face, topology, depth test, depth write and depth compare op
+        bool supported = false;
+        // polygon mode, color blend enable and color write mask
+        bool supported3 = false;
+
+        PFN_vkCmdSetCullModeEXT cmdSetCullMode = nullptr;
+        PFN_vkCmdSetFrontFaceEXT cmdSetFrontFace = nullptr;
+        PFN_vkCmdSetPrimitiveTopologyEXT cmdSetPrimitiveTopology = nullptr;
+        PFN_vkCmdSetDepthTestEnableEXT cmdSetDepthTestEnable = nullptr;
+        PFN_vkCmdSetDepthWriteEnableEXT cmdSetDepthWriteEnable = nullptr;
+        PFN_vkCmdSetDepthCompareOpEXT cmdSetDepthCompareOp = nullptr;
+        PFN_vkCmdSetPolygonModeEXT cmdSetPolygonMode = nullptr;
+        PFN_vkCmdSetColorBlendEnableEXT cmdSetColorBlendEnable = nullptr;
+        PFN_vkCmdSetColorWriteMaskEXT cmdSetColorWriteMask = nullptr;
+    };
+
+    // Optional VK_KHR_dynamic_rendering support, rendering straight into image views without
+    // render pass and framebuffer objects. The command functions stay null when unsupported.
+    struct DynamicRendering
+    {
+        bool supported = false;
+
+        PFN_vkCmdBeginRenderingKHR cmdBeginRendering = nullptr;
+        PFN_vkCmdEndRenderingKHR cmdEndRendering = nullptr;
+    };
+
+    // Optional VK_KHR_push_descriptor support, the command functions stay null when unsupported
+    struct PushDescriptor
+    {
+        bool supported = false;
+
+        PFN_vkCmdPushDescriptorSetKHR cmdPushDescriptorSet = nullptr;
+        PFN_vkCmdPushDescriptorSetWithTemplateKHR cmdPushDescriptorSetWithTemplate = nullptr;
+    };
+
+    // Optional VK_EXT_descriptor_indexing support for the bindless resource table, with the
+    // largest arrays an update-after-bind set may hold on this device.
+    struct DescriptorIndexing
+    {
+        bool supported = false;
+        uint32_t maxStorageBuffers = 0;
+        uint32_t maxSampledImages = 0;
+        uint32_t maxSamplers = 0;
+    };
+
+    // Frame pacing chosen per deployment and fixed for the lifetime of the device. Everything
+    // kept once per frame in flight is sized from framesInFlight.
+    struct FrameConfig
+    {
+        uint32_t framesInFlight = 2;
+        // swap chain images requested on top of the surface's minimum
+        uint32_t extraSwapChainImages = 1;
+        // acquire and present on a separate thread, see LvePresentThread
+        bool presentThread = false;
+        // tried in order, FIFO is the fallback every surface supports
+        std::vector<VkPresentModeKHR> presentModes{VK_PRESENT_MODE_MAILBOX_KHR};
+
+        // one frame in flight, presents without waiting for vertical blank where possible
+        static FrameConfig lowLatency();
+        // three frames in flight, more swap chain images and a present thread to keep the queue busy
+        static FrameConfig throughput();
+    };
+
     class LveDevice
     {
     public:
@@ -33,8 +105,9 @@ namespace lve
 #else
         const bool enableValidationLayers = true;
 #endif
+        static constexpr const char *PIPELINE_CACHE_FILE = "pipeline_cache.bin";
 
-        LveDevice(LveWindow &window);
+        LveDevice(LveWindow &window, const FrameConfig &frameConfig = FrameConfig{});
         ~LveDevice();
 
         // Not copyable or movable
@@ -43,11 +116,57 @@ namespace lve
         LveDevice(LveDevice &&) = delete;
         LveDevice &operator=(LveDevice &&) = delete;
 
+        // Everything below may be called from any thread unless noted otherwise: buffer and image
+        // creation only touch the device, one-time commands record into a command pool of the
+        // calling thread and all queue access goes through submit, present and waitIdle.
+
+        // the renderer's pool for frame command buffers, externally synchronized
         VkCommandPool getCommandPool() { return commandPool; }
+        // Pool held by the calling thread until it exits. The thread then resets it and hands it
+        // back, so a later thread may take it over but never shares it with a running one.
+        VkCommandPool getThreadCommandPool();
         VkDevice device() { return device_; }
         VkSurfaceKHR surface() { return surface_; }
+        // raw queues are externally synchronized, submit and present lock around them
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        // shared by every pipeline creation, persisted to PIPELINE_CACHE_FILE between runs
+        VkPipelineCache pipelineCache() { return pipelineCache_; }
+        bool isPipelineCacheWarm() const { return pipelineCacheWarm; }
+        void savePipelineCache();
+
+        const FrameConfig &getFrameConfig() const { return frameConfig; }
+        uint32_t getFramesInFlight() const { return frameConfig.framesInFlight; }
+
+        // Every submission to the graphics queue signals the next value of one timeline semaphore,
+        // so frames and uploads share a single clock the cpu waits on for exactly the work it
+        // needs. submit chains the timeline signal and returns the value it signals.
+        uint64_t submit(const VkSubmitInfo &submitInfo);
+        void waitForTimeline(uint64_t value);
+        uint64_t getCompletedTimelineValue();
+        VkSemaphore timelineSemaphore() { return timelineSemaphore_; }
+        // presents under the same lock as submit, the graphics and present queue may be one
+        VkResult present(const VkPresentInfoKHR &presentInfo);
+        // vkDeviceWaitIdle needs every queue externally synchronized
+        void waitIdle();
+
+        // Deferred destruction of Vulkan objects that frames in flight may still use. destroy is
+        // tagged with the frame being recorded and runs once the renderer reported that frame
+        // finished, so resources can be dropped mid-frame without idling the device.
+        void deferDestroy(std::function<void()> destroy);
+        uint64_t getCurrentFrame() const { return currentFrame; }
+        // called by the renderer after submitting the current frame
+        void endFrame() { currentFrame++; }
+        // every frame before completedFrame has finished executing on the device
+        void completeFrames(uint64_t completedFrame);
+
+        // Resources report their raw handle when they are destroyed, so caches keyed on handles
+        // drop their entries before the driver hands the same value out again. Listeners run on
+        // the destroying thread and must not add or remove listeners themselves.
+        using HandleListener = std::function<void(uint64_t handle)>;
+        uint64_t addHandleListener(HandleListener listener);
+        void removeHandleListener(uint64_t id);
+        void releaseHandle(uint64_t handle);
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -74,7 +193,17 @@ namespace lve
             VkImage &image,
             VkDeviceMemory &imageMemory);
 
+        bool supportsMultiDrawIndirect() const
+        {
+            return enabledFeatures.multiDrawIndirect && enabledFeatures.drawIndirectFirstInstance;
+        }
+
         VkPhysicalDeviceProperties properties;
+        VkPhysicalDeviceFeatures enabledFeatures{};
+        ExtendedDynamicState extendedDynamicState{};
+        DescriptorIndexing descriptorIndexing{};
+        PushDescriptor pushDescriptor{};
+        DynamicRendering dynamicRendering{};
 
     private:
         void createInstance();
@@ -83,6 +212,14 @@ namespace lve
         void pickPhysicalDevice();
         void createLogicalDevice();
         void createCommandPool();
+        VkCommandPool createGraphicsCommandPool();
+        void createPipelineCache();
+        void createTimelineSemaphore();
+        void loadExtendedDynamicState();
+        void loadPushDescriptor();
+        void loadDynamicRendering();
+        void queryDescriptorIndexingLimits();
+        std::vector<char> readPipelineCacheFile();
 
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
@@ -92,18 +229,60 @@ namespace lve
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
         void hasGflwRequiredInstanceExtensions();
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char *extensionName);
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
         LveWindow &window;
+        FrameConfig frameConfig;
         VkCommandPool commandPool;
 
+        // Outlives the device while threads still hold leases, a lease handed back after the
+        // device was destroyed finds destroyed set and leaves its pool alone.
+        struct ThreadCommandPools
+        {
+            std::mutex mutex;
+            VkDevice device = VK_NULL_HANDLE;
+            std::vector<VkCommandPool> pools{};
+            std::vector<VkCommandPool> freePools{};
+            bool destroyed = false;
+        };
+        // one per thread and device, kept in a thread_local list and handed back on thread exit
+        struct ThreadCommandPoolLease
+        {
+            std::shared_ptr<ThreadCommandPools> owner;
+            VkCommandPool pool;
+
+            ~ThreadCommandPoolLease();
+        };
+        std::shared_ptr<ThreadCommandPools> threadCommandPools = std::make_shared<ThreadCommandPools>();
+
         VkDevice device_;
         VkSurfaceKHR surface_;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+        bool pipelineCacheWarm = false;
+
+        VkSemaphore timelineSemaphore_ = VK_NULL_HANDLE;
+        std::mutex queueMutex;
+        // last value handed to a submission
+        uint64_t timelineValue = 0;
+
+        struct DeferredDestroy
+        {
+            std::function<void()> destroy;
+            uint64_t frame;
+        };
+        std::mutex deletionMutex;
+        std::vector<DeferredDestroy> deletionQueue;
+        std::atomic<uint64_t> currentFrame{0};
+
+        std::mutex listenerMutex;
+        std::unordered_map<uint64_t, HandleListener> handleListeners{};
+        uint64_t nextListenerId = 0;
 
         const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
         const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
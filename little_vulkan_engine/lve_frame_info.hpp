@@ -1,10 +1,12 @@
 #pragma once
 
 #include "lve_camera.hpp"
-#include "lve_game_object.hpp"
+#include "lve_scene.hpp"
 
 #include <vulkan/vulkan.h>
 
+#include <vector>
+
 namespace lve{
     #define MAX_LIGHTS 10
 
@@ -13,13 +15,47 @@ namespace lve{
         glm::vec4 color{};
     };
 
+    // a visible entity drawn on its own, the model is borrowed from its ModelComponent
+    struct RenderObject {
+        LveScene::id_t id;
+        LveModel *model;
+        // where its per object data lives, kept for the lifetime of the entity
+        uint32_t objectSlot;
+    };
+
+    // new per object data for a slot whose entity moved or got it assigned this frame
+    struct ObjectUpdate {
+        uint32_t objectSlot;
+        glm::mat4 modelMatrix{1.f};
+        glm::mat4 normalMatrix{1.f};
+    };
+
+    struct RenderLight {
+        glm::vec3 position{};
+        // w is the intensity
+        glm::vec4 color{};
+        float radius;
+    };
+
+    // Everything recording a frame needs from the simulation, extracted so the simulation can
+    // move on to the next frame while this one is recorded. See LveFramePipeline.
+    struct RenderState {
+        float frameTime = 0.f;
+        LveCamera camera{};
+        std::vector<RenderObject> objects{};
+        std::vector<ObjectUpdate> objectUpdates{};
+        std::vector<RenderLight> lights{};
+        bool depthPrepass = false;
+        bool wireframe = false;
+    };
+
     struct FrameInfo {
         int frameIndex;
         float frameTime;
         VkCommandBuffer commandBuffer;
-        LveCamera &camera;
+        const LveCamera &camera;
         VkDescriptorSet globalDescriptorSet;
-        LveGameObject::Map &gameObjects;
+        const RenderState &renderState;
     };
 
     struct GlobalUbo
@@ -0,0 +1,95 @@
+#include "lve_frame_pipeline.hpp"
+
+namespace lve
+{
+    LveFramePipeline::LveFramePipeline(RenderFunction render)
+        : render{std::move(render)}, thread{&LveFramePipeline::renderLoop, this}
+    {
+    }
+
+    LveFramePipeline::~LveFramePipeline() { this->stop(); }
+
+    void LveFramePipeline::publish(const std::function<void()> &sync)
+    {
+        std::unique_lock<std::mutex> lock{this->mutex};
+        this->stateChanged.wait(lock, [this] { return (!this->pending && !this->rendering) || this->renderError; });
+        if (this->renderError)
+        {
+            std::rethrow_exception(this->renderError);
+        }
+
+        if (sync)
+        {
+            sync();
+        }
+
+        this->readIndex = this->writeIndex;
+        this->writeIndex ^= 1;
+        this->pending = true;
+        this->stateChanged.notify_all();
+    }
+
+    void LveFramePipeline::finish()
+    {
+        this->stop();
+
+        std::lock_guard<std::mutex> lock{this->mutex};
+        if (this->renderError)
+        {
+            std::rethrow_exception(this->renderError);
+        }
+    }
+
+    void LveFramePipeline::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock{this->mutex};
+            this->closed = true;
+        }
+        this->stateChanged.notify_all();
+
+        if (this->thread.joinable())
+        {
+            this->thread.join();
+        }
+    }
+
+    void LveFramePipeline::renderLoop()
+    {
+        while (true)
+        {
+            int index;
+            {
+                std::unique_lock<std::mutex> lock{this->mutex};
+                this->stateChanged.wait(lock, [this] { return this->pending || this->closed; });
+                if (!this->pending)
+                {
+                    return;
+                }
+
+                this->pending = false;
+                this->rendering = true;
+                index = this->readIndex;
+            }
+
+            try
+            {
+                this->render(this->states[index]);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{this->mutex};
+                this->renderError = std::current_exception();
+                this->rendering = false;
+                this->stateChanged.notify_all();
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock{this->mutex};
+                this->rendering = false;
+            }
+            this->stateChanged.notify_all();
+        }
+    }
+}
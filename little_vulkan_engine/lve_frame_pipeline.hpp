@@ -0,0 +1,59 @@
+#pragma once
+
+#include "lve_frame_info.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace lve
+{
+    // Simulates frame N+1 on the calling thread while a render thread records and submits frame
+    // N. The simulation extracts what rendering needs into one of two RenderState buffers and
+    // publish hands it over once the render thread finished the previous one, so both sides
+    // always work on their own buffer. Everything that touches Vulkan objects belongs on the
+    // render thread or into the sync step of publish.
+    class LveFramePipeline
+    {
+    public:
+        using RenderFunction = std::function<void(const RenderState &)>;
+
+        // starts the render thread, render is called there once per published state
+        LveFramePipeline(RenderFunction render);
+        ~LveFramePipeline();
+
+        LveFramePipeline(const LveFramePipeline &) = delete;
+        LveFramePipeline &operator=(const LveFramePipeline &) = delete;
+
+        // the buffer to fill for the next frame, the render thread does not touch it
+        RenderState &getWriteState() { return states[writeIndex]; }
+
+        // Waits until the render thread finished the previously published state, runs sync while
+        // neither side is working and hands the written state over. Rethrows what the render
+        // thread threw.
+        void publish(const std::function<void()> &sync = nullptr);
+        // renders what was published, then stops the render thread
+        void finish();
+
+    private:
+        void renderLoop();
+        void stop();
+
+        RenderFunction render;
+        std::array<RenderState, 2> states{};
+        int writeIndex = 0;
+        int readIndex = 0;
+
+        std::mutex mutex;
+        std::condition_variable stateChanged;
+        bool pending = false;
+        bool rendering = false;
+        bool closed = false;
+        std::exception_ptr renderError{};
+
+        std::thread thread;
+    };
+}
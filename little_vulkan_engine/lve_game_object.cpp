@@ -2,15 +2,38 @@
 
 namespace lve
 {
-    glm::mat4 TransformComponent::mat4()
+    void TransformComponent::setTranslation(const glm::vec3 &value)
     {
+        translation = value;
+        dirty = true;
+    }
+
+    void TransformComponent::setScale(const glm::vec3 &value)
+    {
+        scale = value;
+        dirty = true;
+    }
+
+    void TransformComponent::setRotation(const glm::vec3 &value)
+    {
+        rotation = value;
+        dirty = true;
+    }
+
+    bool TransformComponent::update()
+    {
+        if (!dirty)
+        {
+            return false;
+        }
+
         const float c3 = glm::cos(rotation.z);
         const float s3 = glm::sin(rotation.z);
         const float c2 = glm::cos(rotation.x);
         const float s2 = glm::sin(rotation.x);
         const float c1 = glm::cos(rotation.y);
         const float s1 = glm::sin(rotation.y);
-        return glm::mat4{
+        modelMatrix = glm::mat4{
             {
                 scale.x * (c1 * c3 + s1 * s2 * s3),
                 scale.x * (c2 * s3),
@@ -30,19 +53,9 @@ namespace lve
                 0.0f,
             },
             {translation.x, translation.y, translation.z, 1.0f}};
-    }
 
-    glm::mat3 TransformComponent::normalMatrix()
-    {
-        const float c3 = glm::cos(rotation.z);
-        const float s3 = glm::sin(rotation.z);
-        const float c2 = glm::cos(rotation.x);
-        const float s2 = glm::sin(rotation.x);
-        const float c1 = glm::cos(rotation.y);
-        const float s1 = glm::sin(rotation.y);
         const glm::vec3 invScale = 1.0f / scale;
-
-        return glm::mat3{
+        normal = glm::mat3{
             {
                 invScale.x * (c1 * c3 + s1 * s2 * s3),
                 invScale.x * (c2 * s3),
@@ -58,19 +71,8 @@ namespace lve
                 invScale.z * (-s2),
                 invScale.z * (c1 * c2),
             }};
-    }
-
-    LveGameObject LveGameObject::makePointLight(
-        float intesity,
-        float radius,
-        glm::vec3 color)
-    {
-        LveGameObject gameObj = LveGameObject::createGameObject();
-        gameObj.color = color;
-        gameObj.transform.scale.x = radius;
-        gameObj.pointLight = std::make_unique<PointLightComponent>();
-        gameObj.pointLight->lightIntesity = intesity;
 
-        return gameObj;
+        dirty = false;
+        return true;
     }
 }
@@ -4,57 +4,66 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cassert>
 #include <memory>
-#include <unordered_map>
 
 namespace lve
 {
-    struct TransformComponent
+    // Translation, scale and rotation with the model and normal matrix cached. Setters only mark
+    // the transform dirty, update recomputes both matrices with one set of trig calls. LveScene
+    // updates the transforms of its entities once per frame and lists the ones that changed.
+    class TransformComponent
     {
+    public:
+        const glm::vec3 &getTranslation() const { return translation; }
+        const glm::vec3 &getScale() const { return scale; }
+        const glm::vec3 &getRotation() const { return rotation; }
+        void setTranslation(const glm::vec3 &value);
+        void setScale(const glm::vec3 &value);
+        void setRotation(const glm::vec3 &value);
+
+        bool isDirty() const { return dirty; }
+        // reports the transform as changed at the next update, for changes to its entity that
+        // systems following transforms have to see as well
+        void markDirty() { dirty = true; }
+        // recomputes the matrices if anything changed since the last call, returns whether it did
+        bool update();
+
+        const glm::mat4 &mat4() const
+        {
+            assert(!dirty && "transform changed since its last update");
+            return modelMatrix;
+        }
+        const glm::mat3 &normalMatrix() const
+        {
+            assert(!dirty && "transform changed since its last update");
+            return normal;
+        }
+
+    private:
         glm::vec3 translation{};
         glm::vec3 scale{1.f, 1.f, 1.f};
         glm::vec3 rotation{};
 
-        glm::mat4 mat4();
-        glm::mat3 normalMatrix();
+        glm::mat4 modelMatrix{1.f};
+        glm::mat3 normal{1.f};
+        bool dirty = true;
     };
 
     struct PointLightComponent {
         float lightIntesity = 1.0f;
+        glm::vec3 color{1.f};
     };
 
-    class LveGameObject
+    struct ModelComponent
     {
-    public:
-        using id_t = unsigned int;
-        using Map = std::unordered_map<id_t, LveGameObject>;
-
         std::shared_ptr<LveModel> model{};
-        glm::vec3 color{};
-        TransformComponent transform{};
-
-        std::unique_ptr<PointLightComponent> pointLight = nullptr;
+        // static objects are merged into pre-transformed batches by LveStaticBatcher
+        bool isStatic = false;
 
-        static LveGameObject createGameObject()
-        {
-            static id_t currentId = 0;
-            return LveGameObject{currentId++};
-        }
-
-        LveGameObject(const LveGameObject &) = delete;
-        LveGameObject &operator=(const LveGameObject &) = delete;
-        LveGameObject(LveGameObject &&) = default;
-        LveGameObject &operator=(LveGameObject &&) = default;
-
-        id_t getId() { return id; }
-        static LveGameObject makePointLight(
-            float intesity = 10.f,
-            float radius = 0.1f,
-            glm::vec3 color = glm::vec3(1.f)
-        );
-
-    private:
-        LveGameObject(id_t objId) : id{objId} {}
-        id_t id;
+        // world space bounds for culling, recomputed when the transform or model changed
+        glm::vec3 worldBoundsMin{0.f};
+        glm::vec3 worldBoundsMax{0.f};
+        const LveModel *boundsModel = nullptr;
     };
 }
@@ -0,0 +1,463 @@
+#include "lve_geometry_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve
+{
+    void LveGeometryPool::FreeList::reset(uint32_t used, uint32_t capacity)
+    {
+        this->blocks.clear();
+        if (used < capacity)
+        {
+            this->blocks.push_back({used, capacity - used});
+        }
+    }
+
+    bool LveGeometryPool::FreeList::allocate(uint32_t count, uint32_t &offset)
+    {
+        for (auto it = this->blocks.begin(); it != this->blocks.end(); ++it)
+        {
+            if (it->count < count)
+            {
+                continue;
+            }
+
+            offset = it->offset;
+            it->offset += count;
+            it->count -= count;
+            if (it->count == 0)
+            {
+                this->blocks.erase(it);
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    void LveGeometryPool::FreeList::release(uint32_t offset, uint32_t count)
+    {
+        auto it = std::lower_bound(
+            this->blocks.begin(),
+            this->blocks.end(),
+            offset,
+            [](const Block &block, uint32_t value) { return block.offset < value; });
+        it = this->blocks.insert(it, Block{offset, count});
+
+        auto next = it + 1;
+        if (next != this->blocks.end() && it->offset + it->count == next->offset)
+        {
+            it->count += next->count;
+            this->blocks.erase(next);
+        }
+
+        if (it != this->blocks.begin())
+        {
+            auto prev = it - 1;
+            if (prev->offset + prev->count == it->offset)
+            {
+                prev->count += it->count;
+                this->blocks.erase(it);
+            }
+        }
+    }
+
+    uint32_t LveGeometryPool::FreeList::totalFree() const
+    {
+        uint32_t total = 0;
+        for (const Block &block : this->blocks)
+        {
+            total += block.count;
+        }
+
+        return total;
+    }
+
+    uint32_t LveGeometryPool::FreeList::largestBlock() const
+    {
+        uint32_t largest = 0;
+        for (const Block &block : this->blocks)
+        {
+            largest = std::max(largest, block.count);
+        }
+
+        return largest;
+    }
+
+    LveGeometryPool::LveGeometryPool(
+        LveDevice &device,
+        const std::vector<uint32_t> &streamStrides,
+        uint32_t vertexCapacity,
+        uint32_t indexCapacity)
+        : lveDevice{device},
+          streamStrides{streamStrides},
+          vertexCapacity{vertexCapacity},
+          indexCapacity{indexCapacity}
+    {
+        assert(!this->streamStrides.empty() && "geometry pool needs at least one vertex stream");
+        this->vertexBuffers = this->createVertexBuffers(vertexCapacity);
+        this->indexBuffer = this->createIndexBuffer(indexCapacity);
+        this->vertexFreeList.reset(0, vertexCapacity);
+        this->indexFreeList.reset(0, indexCapacity);
+    }
+
+    LveGeometryPool::~LveGeometryPool() {}
+
+    std::vector<std::unique_ptr<LveBuffer>> LveGeometryPool::createVertexBuffers(uint32_t capacity)
+    {
+        std::vector<std::unique_ptr<LveBuffer>> buffers{};
+        for (uint32_t stride : this->streamStrides)
+        {
+            buffers.push_back(std::make_unique<LveBuffer>(
+                this->lveDevice,
+                stride,
+                capacity,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+        }
+
+        return buffers;
+    }
+
+    uint32_t LveGeometryPool::getVertexSize() const
+    {
+        uint32_t size = 0;
+        for (uint32_t stride : this->streamStrides)
+        {
+            size += stride;
+        }
+
+        return size;
+    }
+
+    std::unique_ptr<LveBuffer> LveGeometryPool::createIndexBuffer(uint32_t capacity)
+    {
+        return std::make_unique<LveBuffer>(
+            this->lveDevice,
+            sizeof(uint32_t),
+            capacity,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    LveGeometryPool::id_t LveGeometryPool::allocate(
+        const std::vector<const void *> &streamData,
+        uint32_t vertexCount,
+        const uint32_t *indexData,
+        uint32_t indexCount)
+    {
+        assert(vertexCount > 0 && indexCount > 0 && "cannot allocate empty geometry");
+        assert(streamData.size() == this->streamStrides.size() && "one data pointer per vertex stream required");
+
+        // held through the upload, a relocation on another thread would copy the range before it is written
+        std::lock_guard<std::mutex> lock{this->mutex};
+
+        Allocation allocation{};
+        allocation.vertexCount = vertexCount;
+        allocation.indexCount = indexCount;
+        allocation.live = true;
+
+        bool reserved = this->vertexFreeList.allocate(vertexCount, allocation.firstVertex);
+        if (reserved && !this->indexFreeList.allocate(indexCount, allocation.firstIndex))
+        {
+            this->vertexFreeList.release(allocation.firstVertex, vertexCount);
+            reserved = false;
+        }
+
+        if (!reserved)
+        {
+            // Pack the live ranges and grow until the new geometry fits behind them. Frames in
+            // flight keep drawing from the old buffers, whose destruction is deferred, so
+            // ranges freed by them can be dropped right away.
+            this->releasePendingFrees(true);
+
+            uint32_t liveVertices = 0;
+            uint32_t liveIndices = 0;
+            for (const Allocation &live : this->allocations)
+            {
+                if (live.live)
+                {
+                    liveVertices += live.vertexCount;
+                    liveIndices += live.indexCount;
+                }
+            }
+
+            uint32_t newVertexCapacity = this->vertexCapacity;
+            while (newVertexCapacity < liveVertices + vertexCount)
+            {
+                newVertexCapacity *= 2;
+            }
+            uint32_t newIndexCapacity = this->indexCapacity;
+            while (newIndexCapacity < liveIndices + indexCount)
+            {
+                newIndexCapacity *= 2;
+            }
+
+            this->relocate(newVertexCapacity, newIndexCapacity);
+
+            reserved = this->vertexFreeList.allocate(vertexCount, allocation.firstVertex) &&
+                       this->indexFreeList.allocate(indexCount, allocation.firstIndex);
+            if (!reserved)
+            {
+                throw std::runtime_error("failed to allocate geometry from pool");
+            }
+        }
+
+        VkDeviceSize vertexSize = static_cast<VkDeviceSize>(this->getVertexSize()) * vertexCount;
+        VkDeviceSize indexSize = sizeof(uint32_t) * static_cast<VkDeviceSize>(indexCount);
+
+        LveBuffer stagingBuffer{
+            this->lveDevice,
+            1,
+            static_cast<uint32_t>(vertexSize + indexSize),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        };
+        stagingBuffer.map();
+
+        VkCommandBuffer commandBuffer = this->lveDevice.beginSingleTimeCommands();
+
+        VkDeviceSize stagingOffset = 0;
+        for (size_t stream = 0; stream < this->streamStrides.size(); stream++)
+        {
+            VkDeviceSize streamSize = static_cast<VkDeviceSize>(this->streamStrides[stream]) * vertexCount;
+            stagingBuffer.writeToBuffer(const_cast<void *>(streamData[stream]), streamSize, stagingOffset);
+
+            VkBufferCopy vertexCopy{};
+            vertexCopy.srcOffset = stagingOffset;
+            vertexCopy.dstOffset = static_cast<VkDeviceSize>(allocation.firstVertex) * this->streamStrides[stream];
+            vertexCopy.size = streamSize;
+            vkCmdCopyBuffer(
+                commandBuffer,
+                stagingBuffer.getBuffer(),
+                this->vertexBuffers[stream]->getBuffer(),
+                1,
+                &vertexCopy);
+
+            stagingOffset += streamSize;
+        }
+
+        stagingBuffer.writeToBuffer(const_cast<uint32_t *>(indexData), indexSize, stagingOffset);
+
+        VkBufferCopy indexCopy{};
+        indexCopy.srcOffset = stagingOffset;
+        indexCopy.dstOffset = static_cast<VkDeviceSize>(allocation.firstIndex) * sizeof(uint32_t);
+        indexCopy.size = indexSize;
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer.getBuffer(), this->indexBuffer->getBuffer(), 1, &indexCopy);
+
+        this->lveDevice.endSingleTimeCommands(commandBuffer);
+
+        id_t id;
+        if (!this->freeIds.empty())
+        {
+            id = this->freeIds.back();
+            this->freeIds.pop_back();
+            this->allocations[id] = allocation;
+        }
+        else
+        {
+            id = static_cast<id_t>(this->allocations.size());
+            this->allocations.push_back(allocation);
+        }
+
+        return id;
+    }
+
+    void LveGeometryPool::free(id_t id)
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        assert(id < this->allocations.size() && this->allocations[id].live && "freeing invalid geometry allocation");
+
+        // frames still in flight may read these ranges, hand them back in endFrame
+        this->pendingFrees.push_back({id, this->currentFrame});
+    }
+
+    LveGeometryPool::Allocation LveGeometryPool::getAllocation(id_t id) const
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        assert(id < this->allocations.size() && this->allocations[id].live && "invalid geometry allocation");
+        return this->allocations[id];
+    }
+
+    void LveGeometryPool::bind(VkCommandBuffer commandBuffer, uint32_t streamCount)
+    {
+        assert(streamCount > 0 && streamCount <= this->getStreamCount() && "invalid vertex stream count");
+        std::lock_guard<std::mutex> lock{this->mutex};
+
+        std::vector<VkBuffer> buffers(streamCount);
+        std::vector<VkDeviceSize> offsets(streamCount, 0);
+        for (uint32_t stream = 0; stream < streamCount; stream++)
+        {
+            buffers[stream] = this->vertexBuffers[stream]->getBuffer();
+        }
+        vkCmdBindVertexBuffers(commandBuffer, 0, streamCount, buffers.data(), offsets.data());
+        vkCmdBindIndexBuffer(commandBuffer, this->indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    }
+
+    VkBuffer LveGeometryPool::getVertexBuffer(uint32_t stream) const
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        return this->vertexBuffers[stream]->getBuffer();
+    }
+
+    VkBuffer LveGeometryPool::getIndexBuffer() const
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        return this->indexBuffer->getBuffer();
+    }
+
+    void LveGeometryPool::endFrame()
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        this->releasePendingFrees(false);
+        this->currentFrame++;
+
+        if (this->computeFragmentation() > COMPACT_FRAGMENTATION)
+        {
+            this->releasePendingFrees(true);
+            this->relocate(this->vertexCapacity, this->indexCapacity);
+        }
+    }
+
+    void LveGeometryPool::compact()
+    {
+        // no idle needed, see allocate
+        std::lock_guard<std::mutex> lock{this->mutex};
+        this->releasePendingFrees(true);
+        this->relocate(this->vertexCapacity, this->indexCapacity);
+    }
+
+    float LveGeometryPool::getFragmentation() const
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        return this->computeFragmentation();
+    }
+
+    float LveGeometryPool::computeFragmentation() const
+    {
+        float fragmentation = 0.f;
+        for (const FreeList *freeList : {&this->vertexFreeList, &this->indexFreeList})
+        {
+            uint32_t total = freeList->totalFree();
+            if (total > 0)
+            {
+                float listFragmentation = 1.f - static_cast<float>(freeList->largestBlock()) / static_cast<float>(total);
+                fragmentation = std::max(fragmentation, listFragmentation);
+            }
+        }
+
+        return fragmentation;
+    }
+
+    VkDeviceSize LveGeometryPool::getUsedMemory() const
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        VkDeviceSize usedVertices = this->vertexCapacity - this->vertexFreeList.totalFree();
+        VkDeviceSize usedIndices = this->indexCapacity - this->indexFreeList.totalFree();
+
+        return usedVertices * this->getVertexSize() + usedIndices * sizeof(uint32_t);
+    }
+
+    void LveGeometryPool::releasePendingFrees(bool all)
+    {
+        auto released = [&](const PendingFree &pending) {
+            if (!all && this->currentFrame - pending.frame < this->lveDevice.getFramesInFlight())
+            {
+                return false;
+            }
+
+            Allocation &allocation = this->allocations[pending.id];
+            this->vertexFreeList.release(allocation.firstVertex, allocation.vertexCount);
+            this->indexFreeList.release(allocation.firstIndex, allocation.indexCount);
+            allocation.live = false;
+            this->freeIds.push_back(pending.id);
+            return true;
+        };
+
+        this->pendingFrees.erase(
+            std::remove_if(this->pendingFrees.begin(), this->pendingFrees.end(), released),
+            this->pendingFrees.end());
+    }
+
+    // Moves every live allocation to the front of freshly created buffers of the requested
+    // capacity. The device does not need to be idle: frames in flight keep reading the old
+    // buffers, whose LveBuffer destructors hand them to LveDevice::deferDestroy, so they live
+    // until every frame submitted before the swap retired. The copy itself is waited for before
+    // returning. Callers hold mutex and may drop pending frees first, no frame reads their
+    // ranges in the new buffers. Draw commands built earlier are stale, see relocationCount.
+    void LveGeometryPool::relocate(uint32_t newVertexCapacity, uint32_t newIndexCapacity)
+    {
+        this->relocationCount.fetch_add(1, std::memory_order_release);
+        std::vector<std::unique_ptr<LveBuffer>> newVertexBuffers = this->createVertexBuffers(newVertexCapacity);
+        std::unique_ptr<LveBuffer> newIndexBuffer = this->createIndexBuffer(newIndexCapacity);
+
+        // vertex copies are recorded in vertex units and scaled by each stream's stride below
+        std::vector<VkBufferCopy> vertexCopies{};
+        std::vector<VkBufferCopy> indexCopies{};
+        uint32_t vertexOffset = 0;
+        uint32_t indexOffset = 0;
+        for (Allocation &allocation : this->allocations)
+        {
+            if (!allocation.live)
+            {
+                continue;
+            }
+
+            VkBufferCopy vertexCopy{};
+            vertexCopy.srcOffset = allocation.firstVertex;
+            vertexCopy.dstOffset = vertexOffset;
+            vertexCopy.size = allocation.vertexCount;
+            vertexCopies.push_back(vertexCopy);
+
+            VkBufferCopy indexCopy{};
+            indexCopy.srcOffset = static_cast<VkDeviceSize>(allocation.firstIndex) * sizeof(uint32_t);
+            indexCopy.dstOffset = static_cast<VkDeviceSize>(indexOffset) * sizeof(uint32_t);
+            indexCopy.size = static_cast<VkDeviceSize>(allocation.indexCount) * sizeof(uint32_t);
+            indexCopies.push_back(indexCopy);
+
+            allocation.firstVertex = vertexOffset;
+            allocation.firstIndex = indexOffset;
+            vertexOffset += allocation.vertexCount;
+            indexOffset += allocation.indexCount;
+        }
+
+        if (!vertexCopies.empty())
+        {
+            VkCommandBuffer commandBuffer = this->lveDevice.beginSingleTimeCommands();
+            for (size_t stream = 0; stream < this->streamStrides.size(); stream++)
+            {
+                VkDeviceSize stride = this->streamStrides[stream];
+                std::vector<VkBufferCopy> streamCopies = vertexCopies;
+                for (VkBufferCopy &copy : streamCopies)
+                {
+                    copy.srcOffset *= stride;
+                    copy.dstOffset *= stride;
+                    copy.size *= stride;
+                }
+
+                vkCmdCopyBuffer(
+                    commandBuffer,
+                    this->vertexBuffers[stream]->getBuffer(),
+                    newVertexBuffers[stream]->getBuffer(),
+                    static_cast<uint32_t>(streamCopies.size()),
+                    streamCopies.data());
+            }
+            vkCmdCopyBuffer(
+                commandBuffer,
+                this->indexBuffer->getBuffer(),
+                newIndexBuffer->getBuffer(),
+                static_cast<uint32_t>(indexCopies.size()),
+                indexCopies.data());
+            this->lveDevice.endSingleTimeCommands(commandBuffer);
+        }
+
+        this->vertexBuffers = std::move(newVertexBuffers);
+        this->indexBuffer = std::move(newIndexBuffer);
+        this->vertexCapacity = newVertexCapacity;
+        this->indexCapacity = newIndexCapacity;
+        this->vertexFreeList.reset(vertexOffset, newVertexCapacity);
+        this->indexFreeList.reset(indexOffset, newIndexCapacity);
+    }
+}
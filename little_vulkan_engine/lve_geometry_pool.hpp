@@ -0,0 +1,132 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+
+#include <limits>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve
+{
+    // Sub-allocates the geometry of every model out of one device-local buffer per vertex stream
+    // and one index buffer, so a whole scene binds its geometry once and can be drawn with a single
+    // indirect multi-draw. All streams share the same vertex offsets, which lets passes that only
+    // need the first streams (e.g. positions) bind just those. Ranges are handed out by first-fit
+    // free lists; the pool grows and compacts itself when an allocation does not fit.
+    //
+    // Every member is safe to call from any thread; uploads are serialized under the pool lock.
+    // Growing or compacting moves all allocations though, so draw parameters are only read while
+    // no other thread allocates, see getRelocationCount.
+    class LveGeometryPool
+    {
+    public:
+        using id_t = uint32_t;
+
+        static constexpr id_t INVALID_ID = std::numeric_limits<id_t>::max();
+        static constexpr uint32_t DEFAULT_VERTEX_CAPACITY = 1 << 18;
+        static constexpr uint32_t DEFAULT_INDEX_CAPACITY = 1 << 20;
+        static constexpr float COMPACT_FRAGMENTATION = 0.5f;
+
+        struct Allocation
+        {
+            uint32_t firstVertex = 0;
+            uint32_t vertexCount = 0;
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            bool live = false;
+        };
+
+        LveGeometryPool(
+            LveDevice &device,
+            const std::vector<uint32_t> &streamStrides,
+            uint32_t vertexCapacity = DEFAULT_VERTEX_CAPACITY,
+            uint32_t indexCapacity = DEFAULT_INDEX_CAPACITY);
+        ~LveGeometryPool();
+
+        LveGeometryPool(const LveGeometryPool &) = delete;
+        LveGeometryPool &operator=(const LveGeometryPool &) = delete;
+
+        // streamData holds one pointer per stream, each to vertexCount elements of that stream
+        id_t allocate(
+            const std::vector<const void *> &streamData,
+            uint32_t vertexCount,
+            const uint32_t *indexData,
+            uint32_t indexCount);
+        void free(id_t id);
+        Allocation getAllocation(id_t id) const;
+
+        // binds the first streamCount vertex streams to bindings 0..streamCount-1
+        void bind(VkCommandBuffer commandBuffer, uint32_t streamCount);
+        void bind(VkCommandBuffer commandBuffer) { bind(commandBuffer, getStreamCount()); }
+
+        // Returns ranges freed a full frames-in-flight ago to the free lists and compacts the
+        // pool when it became too fragmented. Call once per frame.
+        void endFrame();
+        void compact();
+
+        float getFragmentation() const;
+        LveDevice &getDevice() const { return lveDevice; }
+        uint32_t getStreamCount() const { return static_cast<uint32_t>(streamStrides.size()); }
+        const std::vector<uint32_t> &getStreamStrides() const { return streamStrides; }
+        uint32_t getVertexSize() const;
+        VkDeviceSize getUsedMemory() const;
+        // bumped whenever allocations move, draw parameters read before a change are stale
+        uint64_t getRelocationCount() const { return relocationCount.load(std::memory_order_acquire); }
+        VkBuffer getVertexBuffer(uint32_t stream) const;
+        VkBuffer getIndexBuffer() const;
+
+    private:
+        class FreeList
+        {
+        public:
+            struct Block
+            {
+                uint32_t offset;
+                uint32_t count;
+            };
+
+            void reset(uint32_t used, uint32_t capacity);
+            bool allocate(uint32_t count, uint32_t &offset);
+            void release(uint32_t offset, uint32_t count);
+
+            uint32_t totalFree() const;
+            uint32_t largestBlock() const;
+
+        private:
+            std::vector<Block> blocks{};
+        };
+
+        struct PendingFree
+        {
+            id_t id;
+            uint64_t frame;
+        };
+
+        std::vector<std::unique_ptr<LveBuffer>> createVertexBuffers(uint32_t capacity);
+        std::unique_ptr<LveBuffer> createIndexBuffer(uint32_t capacity);
+        // callers hold mutex
+        float computeFragmentation() const;
+        void releasePendingFrees(bool all);
+        void relocate(uint32_t newVertexCapacity, uint32_t newIndexCapacity);
+
+        LveDevice &lveDevice;
+        std::vector<uint32_t> streamStrides;
+        uint32_t vertexCapacity;
+        uint32_t indexCapacity;
+
+        std::vector<std::unique_ptr<LveBuffer>> vertexBuffers;
+        std::unique_ptr<LveBuffer> indexBuffer;
+        FreeList vertexFreeList{};
+        FreeList indexFreeList{};
+
+        std::vector<Allocation> allocations{};
+        std::vector<id_t> freeIds{};
+        std::vector<PendingFree> pendingFrees{};
+        uint64_t currentFrame = 0;
+        std::atomic<uint64_t> relocationCount{0};
+        mutable std::mutex mutex;
+    };
+}
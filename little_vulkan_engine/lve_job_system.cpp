@@ -0,0 +1,362 @@
+#include "lve_job_system.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace lve
+{
+    struct LveJobSystem::Job
+    {
+        std::function<void()> function;
+        Counter *counter;
+    };
+
+    namespace
+    {
+        // which job system and worker the calling thread belongs to, -1 for outside threads
+        thread_local const LveJobSystem *currentSystem = nullptr;
+        thread_local int currentWorker = -1;
+    }
+
+    LveJobSystem::WorkDeque::WorkDeque() : buffer(DEQUE_CAPACITY) {}
+
+    bool LveJobSystem::WorkDeque::push(Job *job)
+    {
+        int64_t b = this->bottom.load(std::memory_order_relaxed);
+        int64_t t = this->top.load(std::memory_order_acquire);
+        if (b - t >= static_cast<int64_t>(this->buffer.size()))
+        {
+            return false;
+        }
+
+        this->buffer[b % this->buffer.size()].store(job, std::memory_order_relaxed);
+        this->bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    LveJobSystem::Job *LveJobSystem::WorkDeque::pop()
+    {
+        int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+        this->bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = this->top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job *job = this->buffer[b % this->buffer.size()].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // the last job, race the thieves for it
+            if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                job = nullptr;
+            }
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return job;
+    }
+
+    LveJobSystem::Job *LveJobSystem::WorkDeque::steal()
+    {
+        int64_t t = this->top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = this->bottom.load(std::memory_order_acquire);
+        if (t >= b)
+        {
+            return nullptr;
+        }
+
+        Job *job = this->buffer[t % this->buffer.size()].load(std::memory_order_relaxed);
+        if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return nullptr;
+        }
+
+        return job;
+    }
+
+    LveJobSystem::LveJobSystem(uint32_t workerCount, uint32_t reservedThreads)
+        : statsStart{std::chrono::steady_clock::now()}
+    {
+        uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        if (workerCount == 0)
+        {
+            workerCount = hardwareThreads > reservedThreads ? hardwareThreads - reservedThreads : 1;
+        }
+
+        this->workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            this->workers.push_back(std::make_unique<Worker>());
+        }
+
+        // workers only get cores of their own when some are kept free for the main and render thread
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            uint32_t core = reservedThreads + i;
+            int pinnedCore = reservedThreads > 0 && core < hardwareThreads ? static_cast<int>(core) : -1;
+            this->workers[i]->thread = std::thread{&LveJobSystem::workerLoop, this, static_cast<int>(i), pinnedCore};
+        }
+    }
+
+    LveJobSystem::~LveJobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock{this->sleepMutex};
+            this->stopping = true;
+        }
+        this->wake.notify_all();
+
+        for (auto &worker : this->workers)
+        {
+            worker->thread.join();
+        }
+
+        for (Job *job : this->injected)
+        {
+            delete job;
+        }
+    }
+
+    void LveJobSystem::run(std::function<void()> job, Counter *counter)
+    {
+        this->schedule(this->createJob(std::move(job), counter));
+    }
+
+    void LveJobSystem::runAfter(Counter &dependency, std::function<void()> job, Counter *counter)
+    {
+        Job *continuation = this->createJob(std::move(job), counter);
+        {
+            std::lock_guard<std::mutex> lock{dependency.mutex};
+            if (dependency.pending.load(std::memory_order_relaxed) != 0)
+            {
+                dependency.continuations.push_back(continuation);
+                return;
+            }
+        }
+
+        this->schedule(continuation);
+    }
+
+    void LveJobSystem::wait(Counter &counter)
+    {
+        int workerIndex = currentSystem == this ? currentWorker : -1;
+        Worker *worker = workerIndex >= 0 ? this->workers[workerIndex].get() : nullptr;
+
+        while (!counter.isDone())
+        {
+            if (Job *job = this->takeJob(workerIndex))
+            {
+                this->execute(job, worker);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        // the last job may still hold the lock after the count reached zero, the caller is free
+        // to destroy the counter once it is released
+        std::lock_guard<std::mutex> lock{counter.mutex};
+    }
+
+    void LveJobSystem::parallelFor(
+        uint32_t count,
+        uint32_t grainSize,
+        const std::function<void(uint32_t begin, uint32_t end)> &body)
+    {
+        grainSize = std::max(1u, grainSize);
+        if (count <= grainSize)
+        {
+            if (count > 0)
+            {
+                body(0, count);
+            }
+            return;
+        }
+
+        Counter counter{};
+        for (uint32_t begin = grainSize; begin < count; begin += grainSize)
+        {
+            uint32_t end = std::min(count, begin + grainSize);
+            this->run([&body, begin, end]() { body(begin, end); }, &counter);
+        }
+
+        // the calling thread takes the first range itself, then helps with the rest
+        body(0, grainSize);
+        this->wait(counter);
+    }
+
+    std::vector<LveJobSystem::WorkerStats> LveJobSystem::takeStats()
+    {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - this->statsStart).count());
+        this->statsStart = now;
+
+        std::vector<WorkerStats> stats(this->workers.size());
+        for (size_t i = 0; i < this->workers.size(); i++)
+        {
+            uint64_t busy = this->workers[i]->busyNanoseconds.exchange(0, std::memory_order_relaxed);
+            stats[i].jobs = this->workers[i]->jobCount.exchange(0, std::memory_order_relaxed);
+            stats[i].utilization = elapsed > 0.0 ? static_cast<float>(std::min(1.0, busy / elapsed)) : 0.f;
+        }
+
+        return stats;
+    }
+
+    bool LveJobSystem::pinCurrentThread(uint32_t core)
+    {
+#ifdef __linux__
+        if (core >= std::thread::hardware_concurrency())
+        {
+            return false;
+        }
+
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core, &cpus);
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+        return false;
+#endif
+    }
+
+    LveJobSystem::Job *LveJobSystem::createJob(std::function<void()> function, Counter *counter)
+    {
+        if (counter != nullptr)
+        {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return new Job{std::move(function), counter};
+    }
+
+    void LveJobSystem::schedule(Job *job)
+    {
+        // counted before it becomes visible, so a thief never sees the count below zero for long
+        this->queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+
+        bool pushed = currentSystem == this && this->workers[currentWorker]->deque.push(job);
+        if (!pushed)
+        {
+            std::lock_guard<std::mutex> lock{this->injectedMutex};
+            this->injected.push_back(job);
+        }
+
+        // taking the lock orders this against a worker that just found nothing and is about to sleep
+        {
+            std::lock_guard<std::mutex> lock{this->sleepMutex};
+        }
+        this->wake.notify_one();
+    }
+
+    LveJobSystem::Job *LveJobSystem::takeJob(int workerIndex)
+    {
+        Job *job = nullptr;
+        if (workerIndex >= 0)
+        {
+            job = this->workers[workerIndex]->deque.pop();
+        }
+
+        if (job == nullptr)
+        {
+            std::lock_guard<std::mutex> lock{this->injectedMutex};
+            if (!this->injected.empty())
+            {
+                job = this->injected.front();
+                this->injected.pop_front();
+            }
+        }
+
+        size_t workerCount = this->workers.size();
+        for (size_t i = 1; job == nullptr && i <= workerCount; i++)
+        {
+            size_t victim = (static_cast<size_t>(workerIndex + 1) + i) % workerCount;
+            if (static_cast<int>(victim) != workerIndex)
+            {
+                job = this->workers[victim]->deque.steal();
+            }
+        }
+
+        if (job != nullptr)
+        {
+            this->queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        return job;
+    }
+
+    void LveJobSystem::execute(Job *job, Worker *worker)
+    {
+        auto start = std::chrono::steady_clock::now();
+        job->function();
+        if (worker != nullptr)
+        {
+            auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            worker->busyNanoseconds.fetch_add(static_cast<uint64_t>(busy.count()), std::memory_order_relaxed);
+            worker->jobCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (job->counter != nullptr)
+        {
+            this->finish(*job->counter);
+        }
+        delete job;
+    }
+
+    void LveJobSystem::finish(Counter &counter)
+    {
+        std::vector<Job *> continuations{};
+        {
+            std::lock_guard<std::mutex> lock{counter.mutex};
+            assert(counter.pending.load(std::memory_order_relaxed) > 0 && "job counter underflow");
+            if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                continuations.swap(counter.continuations);
+            }
+        }
+
+        for (Job *continuation : continuations)
+        {
+            this->schedule(continuation);
+        }
+    }
+
+    void LveJobSystem::workerLoop(int workerIndex, int core)
+    {
+        currentSystem = this;
+        currentWorker = workerIndex;
+        if (core >= 0)
+        {
+            pinCurrentThread(static_cast<uint32_t>(core));
+        }
+
+        Worker *worker = this->workers[workerIndex].get();
+        while (true)
+        {
+            if (Job *job = this->takeJob(workerIndex))
+            {
+                this->execute(job, worker);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock{this->sleepMutex};
+            if (this->stopping && this->queuedJobs.load() <= 0)
+            {
+                return;
+            }
+            this->wake.wait(lock, [this] { return this->queuedJobs.load() > 0 || this->stopping; });
+        }
+    }
+}
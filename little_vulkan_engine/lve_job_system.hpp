@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace lve
+{
+    // Work-stealing job system shared by the engine subsystems. Every worker owns a Chase-Lev
+    // deque: it pushes and pops its own jobs at the bottom while idle workers steal from the
+    // top. Jobs submitted from other threads (main, render) go through a shared queue. Threads
+    // waiting on a counter run jobs themselves instead of blocking.
+    //
+    // Jobs must not throw.
+    class LveJobSystem
+    {
+        struct Job;
+
+    public:
+        static constexpr uint32_t DEQUE_CAPACITY = 4096;
+
+        // Counts unfinished jobs. Jobs scheduled with runAfter start once it dropped to zero.
+        // A counter must outlive its jobs and must not get new jobs while others wait on it.
+        class Counter
+        {
+        public:
+            Counter() = default;
+            Counter(const Counter &) = delete;
+            Counter &operator=(const Counter &) = delete;
+
+            bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+        private:
+            std::atomic<uint32_t> pending{0};
+            std::mutex mutex;
+            std::vector<Job *> continuations{};
+
+            friend class LveJobSystem;
+        };
+
+        struct WorkerStats
+        {
+            uint64_t jobs;
+            // fraction of the time since the last takeStats spent running jobs
+            float utilization;
+        };
+
+        // workerCount 0 starts one worker per hardware thread left after reservedThreads, which
+        // are kept free for the main and render thread. Workers are pinned to the remaining cores.
+        LveJobSystem(uint32_t workerCount = 0, uint32_t reservedThreads = 0);
+        ~LveJobSystem();
+
+        LveJobSystem(const LveJobSystem &) = delete;
+        LveJobSystem &operator=(const LveJobSystem &) = delete;
+
+        void run(std::function<void()> job, Counter *counter = nullptr);
+        void runAfter(Counter &dependency, std::function<void()> job, Counter *counter = nullptr);
+        // runs jobs on the calling thread until counter dropped to zero
+        void wait(Counter &counter);
+
+        // Calls body with consecutive subranges of [0, count) of at most grainSize elements,
+        // spread over the workers and the calling thread, and returns once all are done.
+        void parallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)> &body);
+
+        uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+        // per worker, since the previous call
+        std::vector<WorkerStats> takeStats();
+
+        // restricts the calling thread to one core, false where unsupported
+        static bool pinCurrentThread(uint32_t core);
+
+    private:
+        // Chase-Lev deque of fixed capacity, see "Correct and Efficient Work-Stealing for Weak
+        // Memory Models" (Lê et al., 2013). push and pop only from the owning worker.
+        class WorkDeque
+        {
+        public:
+            WorkDeque();
+
+            bool push(Job *job);
+            Job *pop();
+            Job *steal();
+
+        private:
+            alignas(64) std::atomic<int64_t> top{0};
+            alignas(64) std::atomic<int64_t> bottom{0};
+            std::vector<std::atomic<Job *>> buffer;
+        };
+
+        struct Worker
+        {
+            WorkDeque deque{};
+            std::atomic<uint64_t> busyNanoseconds{0};
+            std::atomic<uint64_t> jobCount{0};
+            std::thread thread{};
+        };
+
+        Job *createJob(std::function<void()> function, Counter *counter);
+        void schedule(Job *job);
+        Job *takeJob(int workerIndex);
+        void execute(Job *job, Worker *worker);
+        void finish(Counter &counter);
+        void workerLoop(int workerIndex, int core);
+
+        std::vector<std::unique_ptr<Worker>> workers{};
+
+        std::mutex injectedMutex;
+        std::deque<Job *> injected{};
+
+        // jobs queued anywhere and not yet taken, idle workers sleep while it is zero
+        std::atomic<int64_t> queuedJobs{0};
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        std::atomic<bool> stopping{false};
+
+        std::chrono::steady_clock::time_point statsStart;
+    };
+}
@@ -28,126 +28,188 @@ namespace std
 
 namespace lve
 {
-    LveModel::LveModel(LveDevice &device, const LveModel::Builder &builder) : lveDevice(device)
+    LveModel::LveModel(LveGeometryPool &geometryPool, const LveModel::Builder &builder) : geometryPool{geometryPool}
     {
-        createVertexBuffers(builder.vertices);
-        createIndexBuffers(builder.indices);
+        this->computeBounds(builder);
+        this->createBuffers(builder);
     }
 
-    LveModel::~LveModel() {}
+    LveModel::LveModel(LveGeometryPool &geometryPool, std::shared_ptr<const LveModel::Builder> meshCache)
+        : geometryPool{geometryPool}, meshCache{std::move(meshCache)}
+    {
+        assert(this->meshCache != nullptr && "mesh cache must not be null");
+        this->computeBounds(*this->meshCache);
+        this->createBuffers(*this->meshCache);
+    }
+
+    LveModel::~LveModel()
+    {
+        if (this->isResident())
+        {
+            this->geometryPool.free(this->allocation);
+        }
+    }
 
-    std::unique_ptr<LveModel> LveModel::createModelFromFile(LveDevice &device, const std::string &filepath)
+    std::unique_ptr<LveModel> LveModel::createModelFromFile(LveGeometryPool &geometryPool, const std::string &filepath)
     {
         Builder builder{};
         builder.loadModel(filepath);
 
-        return std::make_unique<LveModel>(device, builder);
+        return std::make_unique<LveModel>(geometryPool, builder);
     }
 
-    void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices)
+    void LveModel::computeBounds(const Builder &builder)
     {
-        this->vertexCount = static_cast<uint32_t>(vertices.size());
+        if (builder.vertices.empty())
+        {
+            return;
+        }
+
+        this->boundsMin = this->boundsMax = builder.vertices[0].position;
+        for (const Vertex &vertex : builder.vertices)
+        {
+            this->boundsMin = glm::min(this->boundsMin, vertex.position);
+            this->boundsMax = glm::max(this->boundsMax, vertex.position);
+        }
+    }
+
+    void LveModel::createBuffers(const Builder &builder)
+    {
+        assert(
+            this->geometryPool.getStreamStrides() == Vertex::getStreamStrides() &&
+            "geometry pool streams do not match vertex");
+        this->vertexCount = static_cast<uint32_t>(builder.vertices.size());
         assert(vertexCount >= 3 && "Vertex count must be at least 3");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-        uint32_t vertexSize = sizeof(vertices[0]);
 
-        LveBuffer stagingBuffer{
-            this->lveDevice,
-            vertexSize,
-            this->vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
+        std::vector<glm::vec3> positions(this->vertexCount);
+        std::vector<VertexAttributes> attributes(this->vertexCount);
+        for (uint32_t i = 0; i < this->vertexCount; i++)
+        {
+            const Vertex &vertex = builder.vertices[i];
+            positions[i] = vertex.position;
+            attributes[i] = {vertex.color, vertex.normal, vertex.uv};
+        }
 
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)vertices.data());
+        // everything in the pool is drawn indexed, give non indexed meshes a trivial index list
+        std::vector<uint32_t> sequentialIndices{};
+        const std::vector<uint32_t> *indices = &builder.indices;
+        if (builder.indices.empty())
+        {
+            sequentialIndices.resize(this->vertexCount);
+            for (uint32_t i = 0; i < this->vertexCount; i++)
+            {
+                sequentialIndices[i] = i;
+            }
+            indices = &sequentialIndices;
+        }
+        this->indexCount = static_cast<uint32_t>(indices->size());
 
-        this->vertexBuffer = std::make_unique<LveBuffer>(
-            this->lveDevice,
-            vertexSize,
+        this->allocation = this->geometryPool.allocate(
+            {positions.data(), attributes.data()},
             this->vertexCount,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        );
+            indices->data(),
+            this->indexCount);
+    }
 
-        lveDevice.copyBuffer(stagingBuffer.getBuffer(), this->vertexBuffer->getBuffer(), bufferSize);
+    void LveModel::releaseBuffers()
+    {
+        assert(this->canEvict() && "cannot release buffers of a model without a mesh cache");
+        if (this->isResident())
+        {
+            this->geometryPool.free(this->allocation);
+            this->allocation = LveGeometryPool::INVALID_ID;
+        }
     }
 
-    void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices)
+    void LveModel::makeResident()
     {
-        this->indexCount = static_cast<uint32_t>(indices.size());
-        this->hasIndexBuffer = indexCount > 0;
-        if (!this->hasIndexBuffer)
+        if (this->isResident())
         {
             return;
         }
 
-        VkDeviceSize bufferSize = sizeof(indices[0]) * this->indexCount;
-        uint32_t indexSize = sizeof(indices[0]);
-
-        LveBuffer stagingBuffer {
-            this->lveDevice,
-            indexSize,
-            this->indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *) indices.data());
+        assert(this->canEvict() && "evicted model has no mesh cache to reload from");
+        this->createBuffers(*this->meshCache);
+    }
 
-        this->indexBuffer = std::make_unique<LveBuffer>(
-            this->lveDevice,
-            indexSize,
-            this->indexCount,
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        );
+    VkDeviceSize LveModel::getMemorySize() const
+    {
+        if (!this->isResident())
+        {
+            return 0;
+        }
 
-        lveDevice.copyBuffer(stagingBuffer.getBuffer(), this->indexBuffer->getBuffer(), bufferSize);
+        return static_cast<VkDeviceSize>(this->vertexCount) * this->geometryPool.getVertexSize() +
+               static_cast<VkDeviceSize>(this->indexCount) * sizeof(uint32_t);
     }
 
     void LveModel::draw(VkCommandBuffer commandBuffer)
     {
-        if (this->hasIndexBuffer)
-        {
-            vkCmdDrawIndexed(commandBuffer, this->indexCount, 1, 0, 0, 0);
-        }
-        else
-        {
-            vkCmdDraw(commandBuffer, this->vertexCount, 1, 0, 0);
-        }
+        VkDrawIndexedIndirectCommand command = this->getDrawCommand(0);
+        vkCmdDrawIndexed(
+            commandBuffer,
+            command.indexCount,
+            command.instanceCount,
+            command.firstIndex,
+            command.vertexOffset,
+            command.firstInstance);
     }
 
-    void LveModel::bind(VkCommandBuffer commandBuffer)
+    void LveModel::bind(VkCommandBuffer commandBuffer, VertexInput input)
     {
-        VkBuffer buffers[] = {this->vertexBuffer->getBuffer()};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        this->makeResident();
+        this->geometryPool.bind(commandBuffer, input == VertexInput::PositionOnly ? 1 : this->geometryPool.getStreamCount());
+    }
 
-        if (this->hasIndexBuffer)
-        {
-            vkCmdBindIndexBuffer(commandBuffer, this->indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-        }
+    VkDrawIndexedIndirectCommand LveModel::getDrawCommand(uint32_t firstInstance)
+    {
+        this->makeResident();
+        this->useCount++;
+
+        LveGeometryPool::Allocation range = this->geometryPool.getAllocation(this->allocation);
+        VkDrawIndexedIndirectCommand command{};
+        command.indexCount = range.indexCount;
+        command.instanceCount = 1;
+        command.firstIndex = range.firstIndex;
+        command.vertexOffset = static_cast<int32_t>(range.firstVertex);
+        command.firstInstance = firstInstance;
+
+        return command;
+    }
+
+    std::vector<uint32_t> LveModel::Vertex::getStreamStrides()
+    {
+        return {sizeof(glm::vec3), sizeof(VertexAttributes)};
     }
 
-    std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getBindingDescriptions()
+    std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getBindingDescriptions(VertexInput input)
     {
-        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
-        bindingDescriptions[0].binding = 0;
-        bindingDescriptions[0].stride = sizeof(Vertex);
-        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        std::vector<uint32_t> strides = getStreamStrides();
+        size_t streamCount = input == VertexInput::PositionOnly ? 1 : strides.size();
+
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(streamCount);
+        for (size_t i = 0; i < streamCount; i++)
+        {
+            bindingDescriptions[i].binding = static_cast<uint32_t>(i);
+            bindingDescriptions[i].stride = strides[i];
+            bindingDescriptions[i].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        }
 
         return bindingDescriptions;
     }
 
-    std::vector<VkVertexInputAttributeDescription> LveModel::Vertex::getAttributeDescriptions()
+    std::vector<VkVertexInputAttributeDescription> LveModel::Vertex::getAttributeDescriptions(VertexInput input)
     {
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
-        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)});
-        attributeDescriptions.push_back({1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color)});
-        attributeDescriptions.push_back({2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)});
-        attributeDescriptions.push_back({3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)});
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0});
+        if (input == VertexInput::PositionOnly)
+        {
+            return attributeDescriptions;
+        }
+
+        attributeDescriptions.push_back({1, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexAttributes, color)});
+        attributeDescriptions.push_back({2, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexAttributes, normal)});
+        attributeDescriptions.push_back({3, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(VertexAttributes, uv)});
 
         return attributeDescriptions;
     }
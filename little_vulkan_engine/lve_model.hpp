@@ -1,6 +1,7 @@
 #pragma once
 
 #include "lve_device.hpp"
+#include "lve_geometry_pool.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -8,13 +9,28 @@
 
 #include <memory>
 #include <vector>
-#include "lve_buffer.hpp"
 
 namespace lve
 {
     class LveModel
     {
     public:
+        // Which vertex streams a pipeline reads. Depth, shadow and picking passes only need
+        // positions and use PositionOnly so they fetch 12 bytes per vertex.
+        enum class VertexInput
+        {
+            All,
+            PositionOnly,
+        };
+
+        // Layout of the second vertex stream; positions are tightly packed in the first.
+        struct VertexAttributes
+        {
+            glm::vec3 color;
+            glm::vec3 normal;
+            glm::vec2 uv;
+        };
+
         struct Vertex
         {
             glm::vec3 position;
@@ -22,8 +38,12 @@ namespace lve
             glm::vec3 normal;
             glm::vec2 uv;
 
-            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
-            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions(
+                VertexInput input = VertexInput::All);
+            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(
+                VertexInput input = VertexInput::All);
+            // Strides of the streams a geometry pool has to provide for models.
+            static std::vector<uint32_t> getStreamStrides();
 
             bool operator==(const Vertex &other) const
             {
@@ -42,28 +62,45 @@ namespace lve
             void loadModel(const std::string &filepath);
         };
 
-        LveModel(LveDevice &device, const LveModel::Builder &builder);
+        LveModel(LveGeometryPool &geometryPool, const LveModel::Builder &builder);
+        LveModel(LveGeometryPool &geometryPool, std::shared_ptr<const LveModel::Builder> meshCache);
         ~LveModel();
 
         LveModel(const LveModel &) = delete;
         LveModel &operator=(const LveModel &) = delete;
 
-        static std::unique_ptr<LveModel> createModelFromFile(LveDevice &device, const std::string &filepath);
+        static std::unique_ptr<LveModel> createModelFromFile(LveGeometryPool &geometryPool, const std::string &filepath);
 
-        void bind(VkCommandBuffer commandBuffer);
+        void bind(VkCommandBuffer commandBuffer, VertexInput input = VertexInput::All);
         void draw(VkCommandBuffer commandBuffer);
+        // Draw parameters into the shared geometry pool, for recording indirect multi-draws.
+        VkDrawIndexedIndirectCommand getDrawCommand(uint32_t firstInstance);
+
+        // Residency: a model holding a mesh cache can drop its geometry pool ranges and
+        // re-upload them the next time it is drawn.
+        bool isResident() const { return this->allocation != LveGeometryPool::INVALID_ID; }
+        bool canEvict() const { return this->meshCache != nullptr; }
+        void releaseBuffers();
+        void makeResident();
+        VkDeviceSize getMemorySize() const;
+        uint64_t getUseCount() const { return useCount; }
+        const std::shared_ptr<const Builder> &getMeshCache() const { return meshCache; }
+        // object space bounds of the vertex positions, fixed for the lifetime of the model
+        const glm::vec3 &getBoundsMin() const { return boundsMin; }
+        const glm::vec3 &getBoundsMax() const { return boundsMax; }
 
     private:
-        LveDevice &lveDevice;
-        std::unique_ptr<LveBuffer> vertexBuffer;
-        uint32_t vertexCount;
-
-        std::unique_ptr<LveBuffer> indexBuffer;
-        uint32_t indexCount;
-
-        bool hasIndexBuffer = false;
-
-        void createVertexBuffers(const std::vector<Vertex> &vertices);
-        void createIndexBuffers(const std::vector<uint32_t> &indices);
+        LveGeometryPool &geometryPool;
+        LveGeometryPool::id_t allocation = LveGeometryPool::INVALID_ID;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        glm::vec3 boundsMin{0.f};
+        glm::vec3 boundsMax{0.f};
+
+        std::shared_ptr<const Builder> meshCache{};
+        uint64_t useCount = 0;
+
+        void computeBounds(const Builder &builder);
+        void createBuffers(const Builder &builder);
     };
 }
@@ -0,0 +1,267 @@
+#include "lve_model_registry.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+namespace lve
+{
+    LveModelRegistry::LveModelRegistry(LveGeometryPool &geometryPool, VkDeviceSize memoryBudget, uint64_t evictAfterFrames)
+        : geometryPool{geometryPool},
+          memoryBudget{memoryBudget},
+          evictAfterFrames{std::max<uint64_t>(evictAfterFrames, geometryPool.getDevice().getFramesInFlight())}
+    {
+    }
+
+    LveModelRegistry::~LveModelRegistry() {}
+
+    std::string LveModelRegistry::canonicalPath(const std::string &filepath)
+    {
+        std::error_code error;
+        std::filesystem::path path = std::filesystem::weakly_canonical(filepath, error);
+        if (error)
+        {
+            return std::filesystem::absolute(filepath).lexically_normal().string();
+        }
+
+        return path.string();
+    }
+
+    size_t LveModelRegistry::hashFileContent(const std::string &filepath)
+    {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("failed to open file " + filepath);
+        }
+
+        std::string content{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        return std::hash<std::string_view>{}(content);
+    }
+
+    bool LveModelRegistry::sameMesh(const LveModel &model, const LveModel::Builder &builder)
+    {
+        const std::shared_ptr<const LveModel::Builder> &meshCache = model.getMeshCache();
+        return meshCache != nullptr && meshCache->vertices == builder.vertices && meshCache->indices == builder.indices;
+    }
+
+    std::shared_ptr<LveModel> LveModelRegistry::load(const std::string &filepath)
+    {
+        assert(this->isOwnerThread() && "model registry used off its owning thread");
+        std::string path = canonicalPath(filepath);
+        auto byPath = this->entriesByPath.find(path);
+        if (byPath != this->entriesByPath.end())
+        {
+            return byPath->second->model;
+        }
+
+        size_t contentHash = hashFileContent(path);
+        auto builder = std::make_shared<LveModel::Builder>();
+        builder->loadModel(path);
+
+        // the hash only finds a candidate, a collision must not hand out another file's mesh
+        auto byHash = this->entriesByHash.find(contentHash);
+        if (byHash != this->entriesByHash.end() && sameMesh(*byHash->second->model, *builder))
+        {
+            this->entriesByPath[path] = byHash->second;
+            return byHash->second->model;
+        }
+
+        return this->addEntry(path, contentHash, std::move(builder));
+    }
+
+    std::vector<std::shared_ptr<LveModel>> LveModelRegistry::load(
+        const std::vector<std::string> &filepaths,
+        LveJobSystem &jobSystem)
+    {
+        assert(this->isOwnerThread() && "model registry used off its owning thread");
+        struct PendingFile
+        {
+            std::string path;
+            size_t contentHash = 0;
+            std::shared_ptr<LveModel::Builder> builder{};
+            std::exception_ptr error{};
+        };
+
+        std::vector<std::string> paths(filepaths.size());
+        std::vector<PendingFile> pending{};
+        std::unordered_map<std::string, size_t> pendingByPath{};
+        for (size_t i = 0; i < filepaths.size(); i++)
+        {
+            paths[i] = canonicalPath(filepaths[i]);
+            if (this->entriesByPath.count(paths[i]) == 0 && pendingByPath.count(paths[i]) == 0)
+            {
+                pendingByPath[paths[i]] = pending.size();
+                pending.push_back({paths[i]});
+            }
+        }
+
+        // file reads and obj parsing are independent, the geometry pool upload below is not
+        jobSystem.parallelFor(static_cast<uint32_t>(pending.size()), 1, [&pending](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                PendingFile &file = pending[i];
+                try
+                {
+                    file.contentHash = hashFileContent(file.path);
+                    file.builder = std::make_shared<LveModel::Builder>();
+                    file.builder->loadModel(file.path);
+                }
+                catch (...)
+                {
+                    file.error = std::current_exception();
+                }
+            }
+        });
+
+        for (PendingFile &file : pending)
+        {
+            if (file.error)
+            {
+                std::rethrow_exception(file.error);
+            }
+
+            auto byHash = this->entriesByHash.find(file.contentHash);
+            if (byHash != this->entriesByHash.end() && sameMesh(*byHash->second->model, *file.builder))
+            {
+                this->entriesByPath[file.path] = byHash->second;
+            }
+            else
+            {
+                this->addEntry(file.path, file.contentHash, std::move(file.builder));
+            }
+        }
+
+        std::vector<std::shared_ptr<LveModel>> models(paths.size());
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            models[i] = this->entriesByPath.at(paths[i])->model;
+        }
+
+        return models;
+    }
+
+    std::shared_ptr<LveModel> LveModelRegistry::addEntry(
+        const std::string &path,
+        size_t contentHash,
+        std::shared_ptr<const LveModel::Builder> builder)
+    {
+        auto entry = std::make_shared<Entry>();
+        entry->canonicalPath = path;
+        entry->contentHash = contentHash;
+        entry->model = std::make_shared<LveModel>(this->geometryPool, std::move(builder));
+        entry->lastUsedFrame = this->currentFrame;
+
+        this->entries.push_back(entry);
+        this->entriesByPath[path] = entry;
+        // on a hash collision the first entry keeps the hash, later ones are found by path only
+        this->entriesByHash.emplace(contentHash, entry);
+
+        return entry->model;
+    }
+
+    VkDeviceSize LveModelRegistry::getResidentMemory() const
+    {
+        assert(this->isOwnerThread() && "model registry used off its owning thread");
+        VkDeviceSize total = 0;
+        for (const auto &entry : this->entries)
+        {
+            total += entry->model->getMemorySize();
+        }
+
+        return total;
+    }
+
+    void LveModelRegistry::endFrame()
+    {
+        assert(this->isOwnerThread() && "model registry used off its owning thread");
+        for (const auto &entry : this->entries)
+        {
+            uint64_t useCount = entry->model->getUseCount();
+            if (useCount != entry->lastUseCount)
+            {
+                entry->lastUseCount = useCount;
+                entry->lastUsedFrame = this->currentFrame;
+            }
+        }
+
+        // the registry holds one reference itself, anything above that is a live user
+        std::vector<std::shared_ptr<Entry>> unreferenced{};
+        for (const auto &entry : this->entries)
+        {
+            bool idle = this->currentFrame - entry->lastUsedFrame >= this->evictAfterFrames;
+            if (entry->model.use_count() == 1 && idle)
+            {
+                unreferenced.push_back(entry);
+            }
+        }
+        for (const auto &entry : unreferenced)
+        {
+            this->removeEntry(entry);
+        }
+
+        this->evictToBudget();
+        this->currentFrame++;
+    }
+
+    void LveModelRegistry::evictToBudget()
+    {
+        VkDeviceSize resident = this->getResidentMemory();
+        if (resident <= this->memoryBudget)
+        {
+            return;
+        }
+
+        std::vector<Entry *> candidates{};
+        for (const auto &entry : this->entries)
+        {
+            bool idle = this->currentFrame - entry->lastUsedFrame >= this->evictAfterFrames;
+            if (idle && entry->model->isResident())
+            {
+                candidates.push_back(entry.get());
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const Entry *a, const Entry *b) {
+            return a->lastUsedFrame < b->lastUsedFrame;
+        });
+
+        for (Entry *entry : candidates)
+        {
+            if (resident <= this->memoryBudget)
+            {
+                break;
+            }
+
+            resident -= entry->model->getMemorySize();
+            entry->model->releaseBuffers();
+        }
+    }
+
+    void LveModelRegistry::removeEntry(const std::shared_ptr<Entry> &entry)
+    {
+        for (auto it = this->entriesByPath.begin(); it != this->entriesByPath.end();)
+        {
+            if (it->second == entry)
+            {
+                it = this->entriesByPath.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        auto byHash = this->entriesByHash.find(entry->contentHash);
+        if (byHash != this->entriesByHash.end() && byHash->second == entry)
+        {
+            this->entriesByHash.erase(byHash);
+        }
+        this->entries.erase(std::remove(this->entries.begin(), this->entries.end(), entry), this->entries.end());
+    }
+}
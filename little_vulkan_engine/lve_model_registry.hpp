@@ -0,0 +1,86 @@
+#pragma once
+
+#include "lve_geometry_pool.hpp"
+#include "lve_job_system.hpp"
+#include "lve_model.hpp"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace lve
+{
+    // Shares models loaded from the same file (or from files with identical content) and keeps
+    // the device-local memory used by them under a budget. Models that were not drawn for
+    // evictAfterFrames frames are evicted least recently used first and reloaded from their
+    // cpu side mesh cache the next time they are drawn.
+    //
+    // Owned by the thread that created it, every call asserts it comes from there. The batch load
+    // spreads the parsing over the job system itself; models may still be created and destroyed
+    // from any thread outside of the registry. endFrame reads what the render thread records, so
+    // with a render thread it belongs into the sync step of LveFramePipeline::publish.
+    class LveModelRegistry
+    {
+    public:
+        static constexpr VkDeviceSize DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+        static constexpr uint64_t DEFAULT_EVICT_AFTER_FRAMES = 120;
+
+        LveModelRegistry(
+            LveGeometryPool &geometryPool,
+            VkDeviceSize memoryBudget = DEFAULT_MEMORY_BUDGET,
+            uint64_t evictAfterFrames = DEFAULT_EVICT_AFTER_FRAMES);
+        ~LveModelRegistry();
+
+        LveModelRegistry(const LveModelRegistry &) = delete;
+        LveModelRegistry &operator=(const LveModelRegistry &) = delete;
+
+        std::shared_ptr<LveModel> load(const std::string &filepath);
+        // Reads and parses the files not loaded yet on the job system, then uploads them on the
+        // calling thread. Returns the models in the order of filepaths.
+        std::vector<std::shared_ptr<LveModel>> load(const std::vector<std::string> &filepaths, LveJobSystem &jobSystem);
+
+        // Advances the registry frame clock, drops models nobody references anymore and evicts
+        // idle models while the resident memory is above budget. Call once per frame.
+        void endFrame();
+
+        void setMemoryBudget(VkDeviceSize budget) { memoryBudget = budget; }
+        VkDeviceSize getMemoryBudget() const { return memoryBudget; }
+        VkDeviceSize getResidentMemory() const;
+        size_t size() const { return entries.size(); }
+
+    private:
+        struct Entry
+        {
+            std::string canonicalPath;
+            size_t contentHash;
+            std::shared_ptr<LveModel> model;
+            uint64_t lastUsedFrame = 0;
+            uint64_t lastUseCount = 0;
+        };
+
+        static std::string canonicalPath(const std::string &filepath);
+        static size_t hashFileContent(const std::string &filepath);
+        static bool sameMesh(const LveModel &model, const LveModel::Builder &builder);
+
+        std::shared_ptr<LveModel> addEntry(
+            const std::string &path,
+            size_t contentHash,
+            std::shared_ptr<const LveModel::Builder> builder);
+
+        void removeEntry(const std::shared_ptr<Entry> &entry);
+        void evictToBudget();
+        bool isOwnerThread() const { return std::this_thread::get_id() == ownerThread; }
+
+        LveGeometryPool &geometryPool;
+        VkDeviceSize memoryBudget;
+        uint64_t evictAfterFrames;
+        uint64_t currentFrame = 0;
+        std::thread::id ownerThread = std::this_thread::get_id();
+
+        std::vector<std::shared_ptr<Entry>> entries{};
+        std::unordered_map<std::string, std::shared_ptr<Entry>> entriesByPath{};
+        std::unordered_map<size_t, std::shared_ptr<Entry>> entriesByHash{};
+    };
+}
@@ -2,27 +2,81 @@
 #include <stdexcept>
 #include <iostream>
 #include <cassert>
+#include <cstring>
 
 #include "lve_pipeline.hpp"
 #include "lve_model.hpp"
 
 namespace lve
 {
+    ShaderVariant &ShaderVariant::setRaw(uint32_t constantId, const void *value, size_t size)
+    {
+        for (const VkSpecializationMapEntry &entry : this->entries)
+        {
+            if (entry.constantID == constantId)
+            {
+                assert(entry.size == size && "specialization constant set with a different type");
+                std::memcpy(this->data.data() + entry.offset, value, size);
+                return *this;
+            }
+        }
+
+        VkSpecializationMapEntry entry{};
+        entry.constantID = constantId;
+        entry.offset = static_cast<uint32_t>(this->data.size());
+        entry.size = size;
+        this->entries.push_back(entry);
+        this->data.resize(this->data.size() + size);
+        std::memcpy(this->data.data() + entry.offset, value, size);
+
+        return *this;
+    }
+
+    VkSpecializationInfo ShaderVariant::getSpecializationInfo() const
+    {
+        VkSpecializationInfo info{};
+        info.mapEntryCount = static_cast<uint32_t>(this->entries.size());
+        info.pMapEntries = this->entries.data();
+        info.dataSize = this->data.size();
+        info.pData = this->data.data();
+
+        return info;
+    }
+
     LvePipeline::LvePipeline(
         LveDevice &device,
         const std::string &vertFilePath,
         const std::string &fragFilePath,
         const PipelineConfigInfo &configInfo)
-        : lveDevice{device}
+        : lveDevice{device}, ownsShaderModules{true}
     {
-        this->createGraphicsPipeline(vertFilePath, fragFilePath, configInfo);
+        createShaderModule(this->lveDevice, readFile(vertFilePath), &this->vertShaderModule);
+        createShaderModule(this->lveDevice, readFile(fragFilePath), &this->fragShaderModule);
+        this->createGraphicsPipeline(configInfo);
+    }
+
+    LvePipeline::LvePipeline(
+        LveDevice &device,
+        VkShaderModule vertShaderModule,
+        VkShaderModule fragShaderModule,
+        const PipelineConfigInfo &configInfo)
+        : lveDevice{device}, vertShaderModule{vertShaderModule}, fragShaderModule{fragShaderModule}
+    {
+        this->createGraphicsPipeline(configInfo);
     }
 
     LvePipeline::~LvePipeline()
     {
-        vkDestroyShaderModule(this->lveDevice.device(), this->vertShaderModule, nullptr);
-        vkDestroyShaderModule(this->lveDevice.device(), this->fragShaderModule, nullptr);
-        vkDestroyPipeline(this->lveDevice.device(), this->graphicsPipeline, nullptr);
+        if (this->ownsShaderModules)
+        {
+            vkDestroyShaderModule(this->lveDevice.device(), this->vertShaderModule, nullptr);
+            vkDestroyShaderModule(this->lveDevice.device(), this->fragShaderModule, nullptr);
+        }
+
+        // frames in flight may still use the pipeline, the modules are not needed after creation
+        VkDevice device = this->lveDevice.device();
+        VkPipeline pipeline = this->graphicsPipeline;
+        this->lveDevice.deferDestroy([device, pipeline]() { vkDestroyPipeline(device, pipeline, nullptr); });
     }
 
     std::vector<char> LvePipeline::readFile(const std::string &filePath)
@@ -42,18 +96,16 @@ namespace lve
         return buffer;
     }
 
-    void LvePipeline::createGraphicsPipeline(
-        const std::string &vertFilePath,
-        const std::string &fragFilePath,
-        const PipelineConfigInfo &configInfo)
+    void LvePipeline::createGraphicsPipeline(const PipelineConfigInfo &configInfo)
     {
         assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "cannot create graphics pipeline: no pipelineLayout provided in configInfo");
-        assert(configInfo.renderPass != VK_NULL_HANDLE && "cannot create graphics pipeline: no renderPass provided in configInfo");
-        std::vector<char> vertCode = readFile(vertFilePath);
-        std::vector<char> fragCode = readFile(fragFilePath);
+        assert(
+            (configInfo.renderPass != VK_NULL_HANDLE || configInfo.colorAttachmentFormat != VK_FORMAT_UNDEFINED) &&
+            "cannot create graphics pipeline: no renderPass or attachment formats provided in configInfo");
 
-        createShaderModule(vertCode, &this->vertShaderModule);
-        createShaderModule(fragCode, &this->fragShaderModule);
+        VkSpecializationInfo specializationInfo = configInfo.shaderVariant.getSpecializationInfo();
+        const VkSpecializationInfo *pSpecializationInfo =
+            configInfo.shaderVariant.empty() ? nullptr : &specializationInfo;
 
         VkPipelineShaderStageCreateInfo shaderStages[2];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -62,7 +114,7 @@ namespace lve
         shaderStages[0].pName = "main";
         shaderStages[0].flags = 0;
         shaderStages[0].pNext = nullptr;
-        shaderStages[0].pSpecializationInfo = nullptr;
+        shaderStages[0].pSpecializationInfo = pSpecializationInfo;
 
         shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -70,7 +122,7 @@ namespace lve
         shaderStages[1].pName = "main";
         shaderStages[1].flags = 0;
         shaderStages[1].pNext = nullptr;
-        shaderStages[1].pSpecializationInfo = nullptr;
+        shaderStages[1].pSpecializationInfo = pSpecializationInfo;
 
         auto& bindingDesriptions = configInfo.bindingDescriptions;
         auto& attributeDesriptions = configInfo.attributeDescriptions;
@@ -81,6 +133,13 @@ namespace lve
         vertexInputInfo.pVertexAttributeDescriptions = attributeDesriptions.data();
         vertexInputInfo.pVertexBindingDescriptions = bindingDesriptions.data();
 
+        // configInfo may be a copy, point these at its own members again
+        VkPipelineColorBlendStateCreateInfo colorBlendInfo = configInfo.colorBlendInfo;
+        colorBlendInfo.pAttachments = &configInfo.colorBlendAttachment;
+        VkPipelineDynamicStateCreateInfo dynamicStateInfo = configInfo.dynamicStateInfo;
+        dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
+        dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
+
         VkGraphicsPipelineCreateInfo pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
         pipelineInfo.stageCount = 2;
@@ -90,19 +149,31 @@ namespace lve
         pipelineInfo.pViewportState = &configInfo.viewportInfo;
         pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
         pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
-        pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
+        pipelineInfo.pColorBlendState = &colorBlendInfo;
         pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
-        pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
+        pipelineInfo.pDynamicState = &dynamicStateInfo;
 
         pipelineInfo.layout = configInfo.pipelineLayout;
         pipelineInfo.renderPass = configInfo.renderPass;
         pipelineInfo.subpass = configInfo.subpass;
 
+        // dynamic rendering, the pipeline only has to match the attachment formats
+        VkPipelineRenderingCreateInfoKHR renderingInfo{};
+        if (configInfo.renderPass == VK_NULL_HANDLE)
+        {
+            renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+            renderingInfo.colorAttachmentCount = 1;
+            renderingInfo.pColorAttachmentFormats = &configInfo.colorAttachmentFormat;
+            renderingInfo.depthAttachmentFormat = configInfo.depthAttachmentFormat;
+            pipelineInfo.pNext = &renderingInfo;
+        }
+
+        pipelineInfo.flags = configInfo.createFlags;
         pipelineInfo.basePipelineIndex = -1;
-        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+        pipelineInfo.basePipelineHandle = configInfo.basePipelineHandle;
         if (vkCreateGraphicsPipelines(
             this->lveDevice.device(),
-            VK_NULL_HANDLE,
+            this->lveDevice.pipelineCache(),
             1,
             &pipelineInfo,
             nullptr,
@@ -112,13 +183,13 @@ namespace lve
         }
     }
 
-    void LvePipeline::createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule)
+    void LvePipeline::createShaderModule(LveDevice &device, const std::vector<char> &code, VkShaderModule *shaderModule)
     {
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
         createInfo.codeSize = code.size();
         createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
-        if (vkCreateShaderModule(this->lveDevice.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
+        if (vkCreateShaderModule(device.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create shader module");
         }
@@ -215,4 +286,83 @@ namespace lve
         configInfo.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
         configInfo.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
     }
+
+    void LvePipeline::enablePositionOnlyInput(PipelineConfigInfo& configInfo) {
+        configInfo.bindingDescriptions = LveModel::Vertex::getBindingDescriptions(LveModel::VertexInput::PositionOnly);
+        configInfo.attributeDescriptions = LveModel::Vertex::getAttributeDescriptions(LveModel::VertexInput::PositionOnly);
+    }
+
+    void LvePipeline::setRenderTarget(PipelineConfigInfo& configInfo, const PipelineRenderTarget& renderTarget) {
+        configInfo.renderPass = renderTarget.renderPass;
+        configInfo.colorAttachmentFormat = renderTarget.colorFormat;
+        configInfo.depthAttachmentFormat = renderTarget.depthFormat;
+    }
+
+    void LvePipeline::configureRenderState(
+        PipelineConfigInfo& configInfo,
+        const LveDevice& device,
+        const PipelineRenderState& renderState)
+    {
+        const ExtendedDynamicState& eds = device.extendedDynamicState;
+        const PipelineRenderState defaults{};
+
+        const PipelineRenderState& baked = eds.supported ? defaults : renderState;
+        configInfo.rasterizationInfo.cullMode = baked.cullMode;
+        configInfo.rasterizationInfo.frontFace = baked.frontFace;
+        configInfo.inputAssemblyInfo.topology = baked.topology;
+        configInfo.depthStencilInfo.depthTestEnable = baked.depthTest ? VK_TRUE : VK_FALSE;
+        configInfo.depthStencilInfo.depthWriteEnable = baked.depthWrite ? VK_TRUE : VK_FALSE;
+        configInfo.depthStencilInfo.depthCompareOp = baked.depthCompareOp;
+
+        const PipelineRenderState& baked3 = eds.supported3 ? defaults : renderState;
+        configInfo.rasterizationInfo.polygonMode = baked3.polygonMode;
+        configInfo.colorBlendAttachment.blendEnable = baked3.blendEnable ? VK_TRUE : VK_FALSE;
+        configInfo.colorBlendAttachment.colorWriteMask = baked3.colorWriteMask;
+
+        if (eds.supported)
+        {
+            configInfo.dynamicStateEnables.insert(
+                configInfo.dynamicStateEnables.end(),
+                {VK_DYNAMIC_STATE_CULL_MODE_EXT,
+                 VK_DYNAMIC_STATE_FRONT_FACE_EXT,
+                 VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT,
+                 VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT,
+                 VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT,
+                 VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT});
+        }
+        if (eds.supported3)
+        {
+            configInfo.dynamicStateEnables.insert(
+                configInfo.dynamicStateEnables.end(),
+                {VK_DYNAMIC_STATE_POLYGON_MODE_EXT,
+                 VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT,
+                 VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT});
+        }
+        configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
+        configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
+    }
+
+    void LvePipeline::setRenderState(
+        VkCommandBuffer commandBuffer,
+        const LveDevice& device,
+        const PipelineRenderState& renderState)
+    {
+        const ExtendedDynamicState& eds = device.extendedDynamicState;
+        if (eds.supported)
+        {
+            eds.cmdSetCullMode(commandBuffer, renderState.cullMode);
+            eds.cmdSetFrontFace(commandBuffer, renderState.frontFace);
+            eds.cmdSetPrimitiveTopology(commandBuffer, renderState.topology);
+            eds.cmdSetDepthTestEnable(commandBuffer, renderState.depthTest ? VK_TRUE : VK_FALSE);
+            eds.cmdSetDepthWriteEnable(commandBuffer, renderState.depthWrite ? VK_TRUE : VK_FALSE);
+            eds.cmdSetDepthCompareOp(commandBuffer, renderState.depthCompareOp);
+        }
+        if (eds.supported3)
+        {
+            VkBool32 blendEnable = renderState.blendEnable ? VK_TRUE : VK_FALSE;
+            eds.cmdSetPolygonMode(commandBuffer, renderState.polygonMode);
+            eds.cmdSetColorBlendEnable(commandBuffer, 0, 1, &blendEnable);
+            eds.cmdSetColorWriteMask(commandBuffer, 0, 1, &renderState.colorWriteMask);
+        }
+    }
 }
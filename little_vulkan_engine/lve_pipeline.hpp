@@ -7,27 +7,86 @@
 
 namespace lve
 {
+    // Specialization constant values for a pipeline's shaders, addressed by constant_id. The
+    // same values are offered to every stage; stages ignore ids they do not declare.
+    class ShaderVariant
+    {
+    public:
+        ShaderVariant &set(uint32_t constantId, int32_t value) { return setRaw(constantId, &value, sizeof(value)); }
+        ShaderVariant &set(uint32_t constantId, float value) { return setRaw(constantId, &value, sizeof(value)); }
+        ShaderVariant &set(uint32_t constantId, bool value)
+        {
+            VkBool32 boolValue = value ? VK_TRUE : VK_FALSE;
+            return setRaw(constantId, &boolValue, sizeof(boolValue));
+        }
+
+        bool empty() const { return entries.empty(); }
+        const std::vector<VkSpecializationMapEntry> &getEntries() const { return entries; }
+        const std::vector<char> &getData() const { return data; }
+
+        // points into this variant, which has to outlive the returned struct
+        VkSpecializationInfo getSpecializationInfo() const;
+
+    private:
+        ShaderVariant &setRaw(uint32_t constantId, const void *value, size_t size);
+
+        std::vector<VkSpecializationMapEntry> entries{};
+        std::vector<char> data{};
+    };
+
+    // Fixed function state that becomes command buffer state with extended dynamic state. The
+    // defaults match defaultPipelineConfigInfo.
+    struct PipelineRenderState
+    {
+        VkCullModeFlags cullMode = VK_CULL_MODE_NONE;
+        VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+        VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        bool depthTest = true;
+        bool depthWrite = true;
+        VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+        VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+        bool blendEnable = false;
+        VkColorComponentFlags colorWriteMask =
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    };
+
+    // What pipelines render into: a render pass, or with dynamic rendering only the formats of
+    // the attachments, in which case renderPass is null.
+    struct PipelineRenderTarget
+    {
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+        VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    };
+
+    // Copyable so pipeline descriptions can be queued for later creation. The pointers from
+    // colorBlendInfo and dynamicStateInfo into this struct are re-targeted at creation time.
     struct PipelineConfigInfo
     {
-        PipelineConfigInfo() = default;
-        PipelineConfigInfo(const PipelineConfigInfo&) = delete;
-        PipelineConfigInfo& operator=(const PipelineConfigInfo&) = delete;
 
         std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
-        VkPipelineViewportStateCreateInfo viewportInfo;
-        VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
-        VkPipelineRasterizationStateCreateInfo rasterizationInfo;
-        VkPipelineMultisampleStateCreateInfo multisampleInfo;
-        VkPipelineColorBlendAttachmentState colorBlendAttachment;
-        VkPipelineColorBlendStateCreateInfo colorBlendInfo;
-        VkPipelineDepthStencilStateCreateInfo depthStencilInfo;
+        VkPipelineViewportStateCreateInfo viewportInfo{};
+        VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo{};
+        VkPipelineRasterizationStateCreateInfo rasterizationInfo{};
+        VkPipelineMultisampleStateCreateInfo multisampleInfo{};
+        VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+        VkPipelineColorBlendStateCreateInfo colorBlendInfo{};
+        VkPipelineDepthStencilStateCreateInfo depthStencilInfo{};
 
         std::vector<VkDynamicState> dynamicStateEnables;
-        VkPipelineDynamicStateCreateInfo dynamicStateInfo;
+        VkPipelineDynamicStateCreateInfo dynamicStateInfo{};
         VkPipelineLayout pipelineLayout = nullptr;
         VkRenderPass renderPass = nullptr;
         uint32_t subpass = 0;
+        // used instead of renderPass when it is null, see PipelineRenderTarget
+        VkFormat colorAttachmentFormat = VK_FORMAT_UNDEFINED;
+        VkFormat depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+        ShaderVariant shaderVariant{};
+
+        // creation flags and derivative base, not part of the pipeline state itself
+        VkPipelineCreateFlags createFlags = 0;
+        VkPipeline basePipelineHandle = VK_NULL_HANDLE;
     };
 
     class LvePipeline
@@ -38,26 +97,49 @@ namespace lve
             const std::string &vertFilePath,
             const std::string &fragFilePath,
             const PipelineConfigInfo &configInfo);
+        // uses shader modules owned by the caller, they must outlive pipeline creation
+        LvePipeline(
+            LveDevice &device,
+            VkShaderModule vertShaderModule,
+            VkShaderModule fragShaderModule,
+            const PipelineConfigInfo &configInfo);
 
         ~LvePipeline();
         LvePipeline(const LvePipeline&) = delete;
         LvePipeline& operator=(const LvePipeline&) = delete;
 
         void bind(VkCommandBuffer commandBuffer);
+        VkPipeline getPipeline() const { return graphicsPipeline; }
         static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
         static void enableAlphaBlending(PipelineConfigInfo& configInfo);
+        // only reads the tightly packed position stream, for depth, shadow and picking passes
+        static void enablePositionOnlyInput(PipelineConfigInfo& configInfo);
+        static void setRenderTarget(PipelineConfigInfo& configInfo, const PipelineRenderTarget& renderTarget);
+
+        // Bakes renderState into configInfo, then makes every part of it the device can set
+        // dynamically a dynamic state reset to defaults, so pipelines differing only in those
+        // parts share one description. Without extended dynamic state nothing becomes dynamic
+        // and each render state remains its own pipeline permutation. Pipelines built this way
+        // need setRenderState after every bind.
+        static void configureRenderState(
+            PipelineConfigInfo& configInfo,
+            const LveDevice& device,
+            const PipelineRenderState& renderState);
+        static void setRenderState(
+            VkCommandBuffer commandBuffer,
+            const LveDevice& device,
+            const PipelineRenderState& renderState);
+
+        static std::vector<char> readFile(const std::string &filePath);
+        static void createShaderModule(LveDevice &device, const std::vector<char> &code, VkShaderModule* shaderModule);
 
     private:
         LveDevice &lveDevice;
         VkPipeline graphicsPipeline;
         VkShaderModule vertShaderModule;
         VkShaderModule fragShaderModule;
+        bool ownsShaderModules = false;
 
-        static std::vector<char> readFile(const std::string &filePath);
-        void createGraphicsPipeline(
-            const std::string &vertFilePath,
-            const std::string &fragFilePath,
-            const PipelineConfigInfo &configInfo);
-        void createShaderModule(const std::vector<char> &code, VkShaderModule* shaderModule);
+        void createGraphicsPipeline(const PipelineConfigInfo &configInfo);
     };
 }
@@ -0,0 +1,261 @@
+#include "lve_pipeline_service.hpp"
+
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace lve
+{
+    namespace
+    {
+        // appends the bytes of plain fields, never whole structs, so padding stays out of keys
+        class KeyWriter
+        {
+        public:
+            template <typename T>
+            KeyWriter &add(const T &value)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "pipeline key fields must be plain values");
+                this->bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+                return *this;
+            }
+
+            KeyWriter &addStencil(const VkStencilOpState &state)
+            {
+                return this->add(state.failOp)
+                    .add(state.passOp)
+                    .add(state.depthFailOp)
+                    .add(state.compareOp)
+                    .add(state.compareMask)
+                    .add(state.writeMask)
+                    .add(state.reference);
+            }
+
+            std::string bytes{};
+        };
+    }
+
+    LvePipelineService::LvePipelineService(LveDevice &device, LveJobSystem &jobSystem)
+        : lveDevice{device},
+          jobSystem{jobSystem}
+    {
+    }
+
+    LvePipelineService::~LvePipelineService()
+    {
+        this->waitIdle();
+
+        // the pipelines may still be referenced by systems, but all of them are built by now
+        for (auto &kv : this->shaderModules)
+        {
+            vkDestroyShaderModule(this->lveDevice.device(), kv.second.module, nullptr);
+        }
+    }
+
+    const LvePipelineService::ShaderModule &LvePipelineService::getShaderModule(const std::string &filePath)
+    {
+        auto it = this->shaderModules.find(filePath);
+        if (it != this->shaderModules.end())
+        {
+            return it->second;
+        }
+
+        std::vector<char> code = LvePipeline::readFile(filePath);
+        ShaderModule shaderModule{};
+        shaderModule.contentHash = std::hash<std::string_view>{}(std::string_view(code.data(), code.size()));
+        LvePipeline::createShaderModule(this->lveDevice, code, &shaderModule.module);
+
+        return this->shaderModules[filePath] = shaderModule;
+    }
+
+    std::string LvePipelineService::pipelineKey(
+        const PipelineConfigInfo &configInfo,
+        const ShaderModule &vertShader,
+        const ShaderModule &fragShader)
+    {
+        KeyWriter key{};
+        key.add(vertShader.contentHash).add(fragShader.contentHash);
+
+        key.add(configInfo.bindingDescriptions.size());
+        for (const VkVertexInputBindingDescription &binding : configInfo.bindingDescriptions)
+        {
+            key.add(binding.binding).add(binding.stride).add(binding.inputRate);
+        }
+        key.add(configInfo.attributeDescriptions.size());
+        for (const VkVertexInputAttributeDescription &attribute : configInfo.attributeDescriptions)
+        {
+            key.add(attribute.location).add(attribute.binding).add(attribute.format).add(attribute.offset);
+        }
+
+        key.add(configInfo.viewportInfo.viewportCount).add(configInfo.viewportInfo.scissorCount);
+        key.add(configInfo.inputAssemblyInfo.topology).add(configInfo.inputAssemblyInfo.primitiveRestartEnable);
+
+        const VkPipelineRasterizationStateCreateInfo &raster = configInfo.rasterizationInfo;
+        key.add(raster.flags)
+            .add(raster.depthClampEnable)
+            .add(raster.rasterizerDiscardEnable)
+            .add(raster.polygonMode)
+            .add(raster.cullMode)
+            .add(raster.frontFace)
+            .add(raster.depthBiasEnable)
+            .add(raster.depthBiasConstantFactor)
+            .add(raster.depthBiasClamp)
+            .add(raster.depthBiasSlopeFactor)
+            .add(raster.lineWidth);
+
+        const VkPipelineMultisampleStateCreateInfo &multisample = configInfo.multisampleInfo;
+        key.add(multisample.rasterizationSamples)
+            .add(multisample.sampleShadingEnable)
+            .add(multisample.minSampleShading)
+            .add(multisample.alphaToCoverageEnable)
+            .add(multisample.alphaToOneEnable);
+
+        const VkPipelineColorBlendAttachmentState &blend = configInfo.colorBlendAttachment;
+        key.add(blend.blendEnable)
+            .add(blend.srcColorBlendFactor)
+            .add(blend.dstColorBlendFactor)
+            .add(blend.colorBlendOp)
+            .add(blend.srcAlphaBlendFactor)
+            .add(blend.dstAlphaBlendFactor)
+            .add(blend.alphaBlendOp)
+            .add(blend.colorWriteMask);
+        key.add(configInfo.colorBlendInfo.logicOpEnable).add(configInfo.colorBlendInfo.logicOp);
+        for (float constant : configInfo.colorBlendInfo.blendConstants)
+        {
+            key.add(constant);
+        }
+
+        const VkPipelineDepthStencilStateCreateInfo &depth = configInfo.depthStencilInfo;
+        key.add(depth.depthTestEnable)
+            .add(depth.depthWriteEnable)
+            .add(depth.depthCompareOp)
+            .add(depth.depthBoundsTestEnable)
+            .add(depth.stencilTestEnable)
+            .addStencil(depth.front)
+            .addStencil(depth.back)
+            .add(depth.minDepthBounds)
+            .add(depth.maxDepthBounds);
+
+        key.add(configInfo.dynamicStateEnables.size());
+        for (VkDynamicState state : configInfo.dynamicStateEnables)
+        {
+            key.add(state);
+        }
+
+        key.add(configInfo.pipelineLayout).add(configInfo.renderPass).add(configInfo.subpass);
+        key.add(configInfo.colorAttachmentFormat).add(configInfo.depthAttachmentFormat);
+
+        // map entries are built in set() order, so equal variants serialize identically
+        key.add(configInfo.shaderVariant.getEntries().size());
+        for (const VkSpecializationMapEntry &entry : configInfo.shaderVariant.getEntries())
+        {
+            key.add(entry.constantID).add(entry.offset).add(entry.size);
+        }
+        key.bytes.append(configInfo.shaderVariant.getData().begin(), configInfo.shaderVariant.getData().end());
+
+        return key.bytes;
+    }
+
+    LvePipelineService::Handle LvePipelineService::request(
+        const std::string &vertFilePath,
+        const std::string &fragFilePath,
+        const PipelineConfigInfo &configInfo)
+    {
+        return this->enqueue(vertFilePath, fragFilePath, configInfo, nullptr);
+    }
+
+    LvePipelineService::Handle LvePipelineService::requestDerivative(
+        const Handle &basePipeline,
+        const std::string &vertFilePath,
+        const std::string &fragFilePath,
+        const PipelineConfigInfo &configInfo)
+    {
+        return this->enqueue(vertFilePath, fragFilePath, configInfo, &basePipeline);
+    }
+
+    LvePipelineService::Handle LvePipelineService::enqueue(
+        const std::string &vertFilePath,
+        const std::string &fragFilePath,
+        const PipelineConfigInfo &configInfo,
+        const Handle *basePipeline)
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        this->requestCount++;
+        const ShaderModule &vertShader = this->getShaderModule(vertFilePath);
+        const ShaderModule &fragShader = this->getShaderModule(fragFilePath);
+
+        std::string key = pipelineKey(configInfo, vertShader, fragShader);
+        auto existing = this->pipelines.find(key);
+        if (existing != this->pipelines.end())
+        {
+            return existing->second;
+        }
+
+        // every pipeline may serve as a base
+        PipelineConfigInfo createInfo = configInfo;
+        createInfo.createFlags |= VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+        Handle base = basePipeline != nullptr ? *basePipeline : Handle{};
+
+        VkShaderModule vertShaderModule = vertShader.module;
+        VkShaderModule fragShaderModule = fragShader.module;
+        auto task = std::make_shared<std::packaged_task<std::shared_ptr<LvePipeline>()>>(
+            [this, vertShaderModule, fragShaderModule, createInfo, base]() mutable {
+                if (base.valid())
+                {
+                    createInfo.createFlags |= VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+                    createInfo.basePipelineHandle = base.get()->getPipeline();
+                }
+                return std::make_shared<LvePipeline>(this->lveDevice, vertShaderModule, fragShaderModule, createInfo);
+            });
+
+        Handle handle{};
+        handle.pipeline = task->get_future().share();
+        handle.built = std::make_shared<LveJobSystem::Counter>();
+        this->pipelines[key] = handle;
+
+        // packaged_task stores any exception in the handle, so the job never throws. It owns a
+        // reference to its counter, which the job system still touches after the task returned.
+        auto build = [task, built = handle.built]() { (*task)(); };
+        if (base.valid())
+        {
+            this->jobSystem.runAfter(*base.built, std::move(build), handle.built.get());
+        }
+        else
+        {
+            this->jobSystem.run(std::move(build), handle.built.get());
+        }
+
+        return handle;
+    }
+
+    void LvePipelineService::waitIdle()
+    {
+        // waiting runs other jobs, so it happens without holding the lock
+        std::vector<std::shared_ptr<LveJobSystem::Counter>> pending{};
+        {
+            std::lock_guard<std::mutex> lock{this->mutex};
+            pending.reserve(this->pipelines.size());
+            for (auto &kv : this->pipelines)
+            {
+                pending.push_back(kv.second.built);
+            }
+        }
+
+        for (const auto &built : pending)
+        {
+            this->jobSystem.wait(*built);
+        }
+    }
+
+    size_t LvePipelineService::getRequestCount() const
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        return this->requestCount;
+    }
+
+    size_t LvePipelineService::getPipelineCount() const
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        return this->pipelines.size();
+    }
+}
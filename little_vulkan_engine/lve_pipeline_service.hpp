@@ -0,0 +1,97 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_job_system.hpp"
+#include "lve_pipeline.hpp"
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace lve
+{
+    // Builds pipelines as jobs on the job system. Systems request their pipelines up front and
+    // only block in Handle::get() when they first bind one, so independent pipelines compile
+    // concurrently. Every SPIR-V file is read and turned into a shader module once and shared by
+    // all pipelines using it. Requests may come from any thread, e.g. the render thread
+    // switching variants, and are serialized by a mutex; builds run outside of it.
+    //
+    // Requests are deduplicated: the full pipeline state plus the content of both shaders forms
+    // the key, and identical descriptions share one pipeline handle across systems.
+    class LvePipelineService
+    {
+    public:
+        // a pipeline that may still be building, get() blocks until it is done and rethrows
+        // anything its creation threw
+        class Handle
+        {
+        public:
+            Handle() = default;
+
+            const std::shared_ptr<LvePipeline> &get() const { return pipeline.get(); }
+            bool valid() const { return pipeline.valid(); }
+
+        private:
+            std::shared_future<std::shared_ptr<LvePipeline>> pipeline{};
+            // drops to zero once the build finished, derivatives are scheduled behind it
+            std::shared_ptr<LveJobSystem::Counter> built{};
+
+            friend class LvePipelineService;
+        };
+
+        LvePipelineService(LveDevice &device, LveJobSystem &jobSystem);
+        ~LvePipelineService();
+
+        LvePipelineService(const LvePipelineService &) = delete;
+        LvePipelineService &operator=(const LvePipelineService &) = delete;
+
+        Handle request(
+            const std::string &vertFilePath,
+            const std::string &fragFilePath,
+            const PipelineConfigInfo &configInfo);
+        // Like request, but creates the pipeline with VK_PIPELINE_CREATE_DERIVATIVE_BIT from
+        // basePipeline, which lets the driver reuse work for near-identical variants.
+        Handle requestDerivative(
+            const Handle &basePipeline,
+            const std::string &vertFilePath,
+            const std::string &fragFilePath,
+            const PipelineConfigInfo &configInfo);
+
+        // blocks until every requested pipeline has been built
+        void waitIdle();
+
+        size_t getRequestCount() const;
+        size_t getPipelineCount() const;
+
+    private:
+        struct ShaderModule
+        {
+            VkShaderModule module;
+            size_t contentHash;
+        };
+
+        static std::string pipelineKey(
+            const PipelineConfigInfo &configInfo,
+            const ShaderModule &vertShader,
+            const ShaderModule &fragShader);
+
+        // callers hold mutex
+        const ShaderModule &getShaderModule(const std::string &filePath);
+        Handle enqueue(
+            const std::string &vertFilePath,
+            const std::string &fragFilePath,
+            const PipelineConfigInfo &configInfo,
+            const Handle *basePipeline);
+
+        LveDevice &lveDevice;
+        LveJobSystem &jobSystem;
+
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, ShaderModule> shaderModules{};
+        // serialized pipeline state and shader hashes to the pipeline built from them
+        std::unordered_map<std::string, Handle> pipelines{};
+        size_t requestCount = 0;
+    };
+}
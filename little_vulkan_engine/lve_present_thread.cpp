@@ -0,0 +1,60 @@
+#include "lve_present_thread.hpp"
+
+namespace lve
+{
+    LvePresentThread::LvePresentThread() : thread{&LvePresentThread::run, this} {}
+
+    LvePresentThread::~LvePresentThread()
+    {
+        Request request{};
+        request.stop = true;
+        this->requests.push(request);
+        this->thread.join();
+    }
+
+    void LvePresentThread::requestPresent(LveSwapChain &swapChain, uint32_t imageIndex, bool acquireNext)
+    {
+        Request request{};
+        request.swapChain = &swapChain;
+        request.imageIndex = imageIndex;
+        request.present = true;
+        request.acquire = acquireNext;
+        this->requests.push(request);
+    }
+
+    void LvePresentThread::requestAcquire(LveSwapChain &swapChain)
+    {
+        Request request{};
+        request.swapChain = &swapChain;
+        request.acquire = true;
+        this->requests.push(request);
+    }
+
+    LvePresentThread::Acquired LvePresentThread::waitAcquired() { return this->acquired.pop(); }
+
+    void LvePresentThread::run()
+    {
+        while (true)
+        {
+            Request request = this->requests.pop();
+            if (request.stop)
+            {
+                return;
+            }
+
+            Acquired result{};
+            if (request.present)
+            {
+                result.presentResult = request.swapChain->present(request.imageIndex);
+            }
+
+            // a stale swap chain is recreated by the render thread before anything is acquired
+            if (request.acquire && result.presentResult == VK_SUCCESS)
+            {
+                result.acquireResult = request.swapChain->acquireNextImage(&result.imageIndex);
+            }
+
+            this->acquired.push(result);
+        }
+    }
+}
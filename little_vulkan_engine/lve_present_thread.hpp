@@ -0,0 +1,55 @@
+#pragma once
+
+#include "lve_spsc_queue.hpp"
+#include "lve_swap_chain.hpp"
+
+#include <thread>
+
+namespace lve
+{
+    // Acquires and presents swap chain images on its own thread, so the blocking of
+    // vkQueuePresentKHR and vkAcquireNextImageKHR under FIFO overlaps the cpu work of the next
+    // frame instead of stalling it. Requests come from the render thread through a lock-free
+    // queue and every request is answered with exactly one Acquired on a second queue. The
+    // render thread may only touch the swap chain while no request is outstanding.
+    class LvePresentThread
+    {
+    public:
+        struct Acquired
+        {
+            uint32_t imageIndex = 0;
+            // VK_ERROR_OUT_OF_DATE_KHR as well when no image was acquired
+            VkResult acquireResult = VK_ERROR_OUT_OF_DATE_KHR;
+            VkResult presentResult = VK_SUCCESS;
+        };
+
+        LvePresentThread();
+        ~LvePresentThread();
+
+        LvePresentThread(const LvePresentThread &) = delete;
+        LvePresentThread &operator=(const LvePresentThread &) = delete;
+
+        // presents imageIndex, then acquires the next image unless acquireNext is false or the
+        // present reported the swap chain stale
+        void requestPresent(LveSwapChain &swapChain, uint32_t imageIndex, bool acquireNext);
+        void requestAcquire(LveSwapChain &swapChain);
+        Acquired waitAcquired();
+
+    private:
+        struct Request
+        {
+            LveSwapChain *swapChain = nullptr;
+            uint32_t imageIndex = 0;
+            bool present = false;
+            bool acquire = false;
+            bool stop = false;
+        };
+
+        void run();
+
+        // one outstanding request plus the stop request
+        LveSpscQueue<Request> requests{2};
+        LveSpscQueue<Acquired> acquired{2};
+        std::thread thread;
+    };
+}
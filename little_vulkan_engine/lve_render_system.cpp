@@ -1,4 +1,5 @@
 #include "lve_render_system.hpp"
+#include "lve_swap_chain.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -6,95 +7,397 @@
 #include <glm/gtc/constants.hpp>
 
 #include <array>
+#include <cassert>
 #include <stdexcept>
 
 namespace lve
 {
-    struct SimplePushConstantData
-    {
-        glm::mat4 modelMatrix{1.f};
-        glm::mat4 normalMatrix{1.f};
-    };
-
-    LveRenderSystem::LveRenderSystem(LveDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : lveDevice{device}
+    LveRenderSystem::LveRenderSystem(
+        LveDevice &device,
+        LvePipelineService &pipelineService,
+        LveDescriptorCache &descriptorCache,
+        LveGeometryPool &geometryPool,
+        LveStaticBatcher &staticBatcher,
+        const PipelineRenderTarget &renderTarget,
+        VkDescriptorSetLayout globalSetLayout,
+        const LightingVariant &lightingVariant,
+        LveBindlessResources *bindless)
+        : lveDevice{device},
+          pipelineService{pipelineService},
+          descriptorCache{descriptorCache},
+          renderTarget{renderTarget},
+          geometryPool{geometryPool},
+          staticBatcher{staticBatcher},
+          bindless{bindless},
+          lightingVariant{lightingVariant}
     {
+        assert(
+            lightingVariant.maxLights >= 0 && lightingVariant.maxLights <= MAX_LIGHTS &&
+            "lighting variant exceeds MAX_LIGHTS");
+        createMaterials();
+        createObjectBuffers();
         createPipelineLayout(globalSetLayout);
-        createPipeline(renderPass);
+        createPipeline();
     }
 
     LveRenderSystem::~LveRenderSystem()
     {
+        if (this->bindless != nullptr)
+        {
+            this->bindless->removeBuffer(this->defaultMaterial);
+        }
         vkDestroyPipelineLayout(this->lveDevice.device(), this->pipelineLayout, nullptr);
     }
 
-    void LveRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+    void LveRenderSystem::createMaterials()
+    {
+        if (this->bindless == nullptr)
+        {
+            return;
+        }
+
+        this->materialBuffer = std::make_unique<LveBuffer>(
+            this->lveDevice,
+            sizeof(Material),
+            1,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        this->materialBuffer->map();
+        Material material{};
+        this->materialBuffer->writeToBuffer(&material);
+        this->materialBuffer->flush();
+
+        this->defaultMaterial = this->bindless->addBuffer(this->materialBuffer->descriptorInfo());
+    }
+
+    void LveRenderSystem::createObjectBuffers()
     {
-        VkPushConstantRange pushConstantRange;
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(SimplePushConstantData);
+        // with push descriptors the object set is recorded into the command buffer every frame
+        // and needs no descriptor sets at all
+        VkDescriptorSetLayoutCreateFlags layoutFlags =
+            this->lveDevice.pushDescriptor.supported ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0;
+        this->objectSetLayout = LveDescriptorSetLayout::Builder(this->lveDevice)
+                                    .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+                                    .setLayoutFlags(layoutFlags)
+                                    .build(this->descriptorCache);
+
+        uint32_t framesInFlight = this->lveDevice.getFramesInFlight();
+        assert(framesInFlight <= 32 && "queued object writes track frames in a 32 bit mask");
+        this->objectBuffers.resize(framesInFlight);
+        this->indirectBuffers.resize(framesInFlight);
+        this->objectDescriptorSets.resize(framesInFlight);
+        for (uint32_t i = 0; i < framesInFlight; i++)
+        {
+            this->objectBuffers[i] = std::make_unique<LveBuffer>(
+                this->lveDevice,
+                sizeof(ObjectData),
+                MAX_OBJECTS,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            this->objectBuffers[i]->map();
+            ObjectData identity{};
+            identity.material = this->defaultMaterial;
+            this->objectBuffers[i]->writeToIndex(&identity, BATCH_OBJECT_SLOT);
+            this->objectBuffers[i]->flush();
+
+            this->indirectBuffers[i] = std::make_unique<LveBuffer>(
+                this->lveDevice,
+                sizeof(VkDrawIndexedIndirectCommand),
+                MAX_OBJECTS,
+                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            this->indirectBuffers[i]->map();
+
+            if (this->objectSetLayout->isPushDescriptor())
+            {
+                continue;
+            }
 
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+            VkDescriptorBufferInfo bufferInfo = this->objectBuffers[i]->descriptorInfo();
+            LveDescriptorWriter(*this->objectSetLayout, this->descriptorCache)
+                .writeBuffer(0, &bufferInfo)
+                .build(this->objectDescriptorSets[i]);
+        }
+
+        this->drawCommands.reserve(MAX_OBJECTS);
+        this->queuedObjectWrites.resize(framesInFlight);
+    }
+
+    void LveRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+    {
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+            globalSetLayout,
+            this->objectSetLayout->getDescriptorSetLayout()};
+        if (this->bindless != nullptr)
+        {
+            descriptorSetLayouts.push_back(this->bindless->getDescriptorSetLayout());
+        }
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
         pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
         if (vkCreatePipelineLayout(this->lveDevice.device(), &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create pipeline layout");
         }
+
+        if (this->objectSetLayout->isPushDescriptor())
+        {
+            this->objectUpdateTemplate = LveDescriptorUpdateTemplate::Builder(this->lveDevice, *this->objectSetLayout)
+                                             .addEntry(0, 0)
+                                             .buildPush(this->pipelineLayout, 1);
+        }
+    }
+
+    void LveRenderSystem::setLightingVariant(const LightingVariant &variant)
+    {
+        assert(variant.maxLights >= 0 && variant.maxLights <= MAX_LIGHTS && "lighting variant exceeds MAX_LIGHTS");
+        this->lightingVariant = variant;
+        this->createPipeline();
     }
 
-    void LveRenderSystem::createPipeline(VkRenderPass renderPass)
+    void LveRenderSystem::createPipeline()
     {
         assert(this->pipelineLayout != nullptr && "cannot create pipeline before pipeline layout");
 
+        // constant ids as declared in shader.frag
+        ShaderVariant lighting{};
+        lighting.set(0, static_cast<int32_t>(this->lightingVariant.maxLights))
+            .set(1, this->lightingVariant.specularExponent)
+            .set(2, this->lightingVariant.specular);
+
         PipelineConfigInfo pipelineConfig{};
         LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
-        pipelineConfig.renderPass = renderPass;
+        LvePipeline::setRenderTarget(pipelineConfig, this->renderTarget);
         pipelineConfig.pipelineLayout = this->pipelineLayout;
-        this->lvePipeline = std::make_unique<LvePipeline>(
-            this->lveDevice,
+        pipelineConfig.shaderVariant = lighting;
+        LvePipeline::configureRenderState(pipelineConfig, this->lveDevice, this->getRenderState(Pass::Shading));
+        // shader.frag compiled with BINDLESS reads the material of each object
+        const char *fragFilePath = this->bindless != nullptr ? "shaders/bindless_frag.spv" : "shaders/frag.spv";
+        this->lvePipeline = this->pipelineService.request(
             "shaders/vert.spv",
-            "shaders/frag.spv",
+            fragFilePath,
             pipelineConfig);
+
+        // with extended dynamic state this describes the same pipeline as above and is shared
+        PipelineConfigInfo equalConfig{};
+        LvePipeline::defaultPipelineConfigInfo(equalConfig);
+        LvePipeline::setRenderTarget(equalConfig, this->renderTarget);
+        equalConfig.pipelineLayout = this->pipelineLayout;
+        equalConfig.shaderVariant = lighting;
+        LvePipeline::configureRenderState(equalConfig, this->lveDevice, this->getRenderState(Pass::ShadingDepthEqual));
+        this->depthEqualPipeline = this->pipelineService.requestDerivative(
+            this->lvePipeline,
+            "shaders/vert.spv",
+            fragFilePath,
+            equalConfig);
+
+        PipelineConfigInfo depthConfig{};
+        LvePipeline::defaultPipelineConfigInfo(depthConfig);
+        LvePipeline::enablePositionOnlyInput(depthConfig);
+        LvePipeline::setRenderTarget(depthConfig, this->renderTarget);
+        depthConfig.pipelineLayout = this->pipelineLayout;
+        LvePipeline::configureRenderState(depthConfig, this->lveDevice, this->getRenderState(Pass::DepthPrepass));
+        this->depthPrepassPipeline = this->pipelineService.request(
+            "shaders/depth_vert.spv",
+            "shaders/depth_frag.spv",
+            depthConfig);
+    }
+
+    void LveRenderSystem::setWireframe(bool enabled)
+    {
+        if (enabled && !this->lveDevice.enabledFeatures.fillModeNonSolid)
+        {
+            return;
+        }
+
+        this->wireframe = enabled;
+        this->createPipeline();
+    }
+
+    PipelineRenderState LveRenderSystem::getRenderState(Pass pass) const
+    {
+        PipelineRenderState state{};
+        switch (pass)
+        {
+        case Pass::DepthPrepass:
+            state.colorWriteMask = 0;
+            break;
+        case Pass::ShadingDepthEqual:
+            state.depthCompareOp = VK_COMPARE_OP_EQUAL;
+            state.depthWrite = false;
+            break;
+        case Pass::Shading:
+            state.polygonMode = this->wireframe ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
+            break;
+        }
+
+        return state;
+    }
+
+    void LveRenderSystem::prepareFrame(const RenderState &renderState)
+    {
+        for (const ObjectUpdate &update : renderState.objectUpdates)
+        {
+            assert(update.objectSlot < MAX_OBJECTS && "Game objects exceed maximum specified");
+            if (update.objectSlot >= this->objectData.size())
+            {
+                this->objectData.resize(update.objectSlot + 1);
+                this->queuedObjectFrames.resize(update.objectSlot + 1, 0);
+            }
+
+            ObjectData &data = this->objectData[update.objectSlot];
+            data.modelMatrix = update.modelMatrix;
+            data.normalMatrix = update.normalMatrix;
+            data.material = this->defaultMaterial;
+            uint32_t &queued = this->queuedObjectFrames[update.objectSlot];
+            for (size_t frame = 0; frame < this->queuedObjectWrites.size(); frame++)
+            {
+                if ((queued & (1u << frame)) == 0)
+                {
+                    queued |= 1u << frame;
+                    this->queuedObjectWrites[frame].push_back(update.objectSlot);
+                }
+            }
+        }
+
+        for (const RenderObject &obj : renderState.objects)
+        {
+            obj.model->makeResident();
+        }
+        for (const LveStaticBatcher::Batch *batch : this->staticBatcher.getBatches())
+        {
+            batch->model->makeResident();
+        }
     }
 
     void LveRenderSystem::renderGameObjects(FrameInfo &frameInfo)
     {
-        this->lvePipeline->bind(frameInfo.commandBuffer);
+        LveBuffer &objectBuffer = *this->objectBuffers[frameInfo.frameIndex];
+        LveBuffer &indirectBuffer = *this->indirectBuffers[frameInfo.frameIndex];
+        // only the slots that changed since this frame's buffer was last written
+        std::vector<uint32_t> &queuedWrites = this->queuedObjectWrites[frameInfo.frameIndex];
+        if (!queuedWrites.empty())
+        {
+            for (uint32_t slot : queuedWrites)
+            {
+                objectBuffer.writeToIndex(&this->objectData[slot], slot);
+                this->queuedObjectFrames[slot] &= ~(1u << frameInfo.frameIndex);
+            }
+            queuedWrites.clear();
+            objectBuffer.flush();
+        }
+
+        // every command below reads its offsets from the same pool layout
+        uint64_t relocations = this->geometryPool.getRelocationCount();
+
+        this->drawCommands.clear();
+        for (const RenderObject &obj : frameInfo.renderState.objects)
+        {
+            assert(this->drawCommands.size() < MAX_OBJECTS && "Game objects exceed maximum specified");
+            this->drawCommands.push_back(obj.model->getDrawCommand(obj.objectSlot));
+        }
+
+        // static batches are already in world space and only need culling
+        for (const LveStaticBatcher::Batch *batch : this->staticBatcher.getBatches())
+        {
+            if (!frameInfo.camera.isBoxVisible(batch->boundsMin, batch->boundsMax)) continue;
+            assert(this->drawCommands.size() < MAX_OBJECTS && "Game objects exceed maximum specified");
+            this->drawCommands.push_back(batch->model->getDrawCommand(BATCH_OBJECT_SLOT));
+        }
+
+        assert(
+            this->geometryPool.getRelocationCount() == relocations &&
+            "geometry pool relocated while recording, call prepareFrame before beginFrame");
+
+        if (this->drawCommands.empty())
+        {
+            return;
+        }
+
+        uint32_t drawCount = static_cast<uint32_t>(this->drawCommands.size());
+        indirectBuffer.writeToBuffer(this->drawCommands.data(), drawCount * sizeof(VkDrawIndexedIndirectCommand));
+        indirectBuffer.flush();
+
+        std::array<VkDescriptorSet, 2> descriptorSets{
+            frameInfo.globalDescriptorSet,
+            this->objectDescriptorSets[frameInfo.frameIndex]};
+        bool pushObjects = this->objectUpdateTemplate != nullptr;
         vkCmdBindDescriptorSets(
             frameInfo.commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             pipelineLayout,
             0,
-            1,
-            &frameInfo.globalDescriptorSet,
+            pushObjects ? 1 : static_cast<uint32_t>(descriptorSets.size()),
+            descriptorSets.data(),
             0,
             nullptr);
+        if (pushObjects)
+        {
+            VkDescriptorBufferInfo bufferInfo = objectBuffer.descriptorInfo();
+            this->objectUpdateTemplate->push(frameInfo.commandBuffer, &bufferInfo);
+        }
+        if (this->bindless != nullptr)
+        {
+            VkDescriptorSet bindlessSet = this->bindless->getDescriptorSet();
+            vkCmdBindDescriptorSets(
+                frameInfo.commandBuffer,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                pipelineLayout,
+                2,
+                1,
+                &bindlessSet,
+                0,
+                nullptr);
+        }
 
-        for (std::pair<const LveGameObject::id_t, LveGameObject> &kv : frameInfo.gameObjects)
+        if (this->depthPrepass && !this->wireframe)
         {
-            LveGameObject& obj = kv.second;
-            if (obj.model == nullptr) continue;
-            SimplePushConstantData push{};
-            glm::mat4 modelMatrix = obj.transform.mat4();
-            push.modelMatrix = obj.transform.mat4();
-            push.normalMatrix = obj.transform.normalMatrix();
+            this->depthPrepassPipeline.get()->bind(frameInfo.commandBuffer);
+            LvePipeline::setRenderState(frameInfo.commandBuffer, this->lveDevice, this->getRenderState(Pass::DepthPrepass));
+            this->geometryPool.bind(frameInfo.commandBuffer, 1);
+            this->drawObjects(frameInfo.commandBuffer, indirectBuffer);
 
-            vkCmdPushConstants(
-                frameInfo.commandBuffer,
-                this->pipelineLayout,
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            this->depthEqualPipeline.get()->bind(frameInfo.commandBuffer);
+            LvePipeline::setRenderState(frameInfo.commandBuffer, this->lveDevice, this->getRenderState(Pass::ShadingDepthEqual));
+        }
+        else
+        {
+            this->lvePipeline.get()->bind(frameInfo.commandBuffer);
+            LvePipeline::setRenderState(frameInfo.commandBuffer, this->lveDevice, this->getRenderState(Pass::Shading));
+        }
+
+        this->geometryPool.bind(frameInfo.commandBuffer);
+        this->drawObjects(frameInfo.commandBuffer, indirectBuffer);
+    }
+
+    void LveRenderSystem::drawObjects(VkCommandBuffer commandBuffer, LveBuffer &indirectBuffer)
+    {
+        if (this->lveDevice.supportsMultiDrawIndirect())
+        {
+            vkCmdDrawIndexedIndirect(
+                commandBuffer,
+                indirectBuffer.getBuffer(),
                 0,
-                sizeof(SimplePushConstantData),
-                &push);
-            obj.model->bind(frameInfo.commandBuffer);
-            obj.model->draw(frameInfo.commandBuffer);
+                static_cast<uint32_t>(this->drawCommands.size()),
+                sizeof(VkDrawIndexedIndirectCommand));
+        }
+        else
+        {
+            for (const VkDrawIndexedIndirectCommand &command : this->drawCommands)
+            {
+                vkCmdDrawIndexed(
+                    commandBuffer,
+                    command.indexCount,
+                    command.instanceCount,
+                    command.firstIndex,
+                    command.vertexOffset,
+                    command.firstInstance);
+            }
         }
     }
 }
@@ -1,10 +1,16 @@
 #pragma once
 
+#include "lve_bindless.hpp"
 #include "lve_camera.hpp"
 #include "lve_pipeline.hpp"
-#include "lve_game_object.hpp"
+#include "lve_pipeline_service.hpp"
+#include "lve_scene.hpp"
 #include "lve_device.hpp"
 #include "lve_frame_info.hpp"
+#include "lve_buffer.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_geometry_pool.hpp"
+#include "lve_static_batcher.hpp"
 
 #include <memory>
 #include <vector>
@@ -14,21 +20,122 @@ namespace lve
     class LveRenderSystem
     {
     public:
-        LveRenderSystem(LveDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        static constexpr uint32_t MAX_OBJECTS = 10000;
+        // The static batches are pre-transformed and share an identity in the first object slot,
+        // entities drawn on their own get one of the slots after it.
+        static constexpr uint32_t BATCH_OBJECT_SLOT = 0;
+        static constexpr uint32_t FIRST_OBJECT_SLOT = 1;
+
+        // Specialization of the lighting loop in shader.frag. Fewer lights and no specular term
+        // give cheaper variants; pick the smallest one that still covers the scene.
+        struct LightingVariant
+        {
+            int maxLights = MAX_LIGHTS;
+            float specularExponent = 32.f;
+            bool specular = false;
+        };
+
+        // With bindless resources, which must outlive the system, every object looks up its
+        // material through an index in its object data; without, all objects are untinted.
+        LveRenderSystem(
+            LveDevice &device,
+            LvePipelineService &pipelineService,
+            LveDescriptorCache &descriptorCache,
+            LveGeometryPool &geometryPool,
+            LveStaticBatcher &staticBatcher,
+            const PipelineRenderTarget &renderTarget,
+            VkDescriptorSetLayout globalSetLayout,
+            const LightingVariant &lightingVariant,
+            LveBindlessResources *bindless = nullptr);
         ~LveRenderSystem();
 
         LveRenderSystem(const LveRenderSystem &) = delete;
         LveRenderSystem &operator=(const LveRenderSystem &) = delete;
 
+        // Takes over the object updates of the state and makes every model the frame draws
+        // resident. Uploading may relocate the geometry pool and with it every draw offset, so
+        // this runs before the frame starts recording, and for every state, recorded or not.
+        void prepareFrame(const RenderState &renderState);
         void renderGameObjects(FrameInfo &frameInfo);
 
+        // With the depth pre-pass enabled, depth is laid down by a position-only pass first and
+        // the shading pass tests VK_COMPARE_OP_EQUAL, so each pixel is lit at most once. Line
+        // rasterization does not reproduce the filled depth, so wireframe bypasses the pre-pass.
+        void setDepthPrepass(bool enabled) { depthPrepass = enabled; }
+        bool isDepthPrepassEnabled() const { return depthPrepass; }
+
+        // Switches the shading pipelines to another variant. Variants are deduplicated by the
+        // pipeline service, so switching back to one used before costs nothing.
+        void setLightingVariant(const LightingVariant &variant);
+        const LightingVariant &getLightingVariant() const { return lightingVariant; }
+
+        // polygon mode line, ignored when the device lacks fillModeNonSolid
+        void setWireframe(bool enabled);
+        bool isWireframeEnabled() const { return wireframe; }
+
     private:
+        // std140 layout of ObjectData in shader.vert and depth.vert
+        struct ObjectData
+        {
+            glm::mat4 modelMatrix{1.f};
+            glm::mat4 normalMatrix{1.f};
+            // bindless buffer index of the Material, unused without bindless
+            uint32_t material = 0;
+            uint32_t padding[3]{};
+        };
+
+        // std430 layout of Material in shader.frag
+        struct Material
+        {
+            glm::vec4 tint{1.f};
+        };
+
+        enum class Pass
+        {
+            DepthPrepass,
+            Shading,
+            ShadingDepthEqual,
+        };
+
+        PipelineRenderState getRenderState(Pass pass) const;
+        void createMaterials();
+        void createObjectBuffers();
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        void createPipeline();
+        void drawObjects(VkCommandBuffer commandBuffer, LveBuffer &indirectBuffer);
 
         LveDevice &lveDevice;
+        LvePipelineService &pipelineService;
+        LveDescriptorCache &descriptorCache;
+        PipelineRenderTarget renderTarget;
+        LveGeometryPool &geometryPool;
+        LveStaticBatcher &staticBatcher;
+        LveBindlessResources *bindless;
+        std::unique_ptr<LveBuffer> materialBuffer;
+        uint32_t defaultMaterial = 0;
 
-        std::unique_ptr<LvePipeline> lvePipeline;
+        LvePipelineService::Handle lvePipeline;
+        LvePipelineService::Handle depthPrepassPipeline;
+        LvePipelineService::Handle depthEqualPipeline;
         VkPipelineLayout pipelineLayout;
+        bool depthPrepass = false;
+        bool wireframe = false;
+        LightingVariant lightingVariant{};
+
+        // per frame object data and draw commands, indexed by gl_InstanceIndex in the shader
+        std::shared_ptr<LveDescriptorSetLayout> objectSetLayout;
+        std::vector<std::unique_ptr<LveBuffer>> objectBuffers;
+        std::vector<std::unique_ptr<LveBuffer>> indirectBuffers;
+        std::vector<VkDescriptorSet> objectDescriptorSets;
+        // set when the device supports push descriptors, replaces objectDescriptorSets
+        std::unique_ptr<LveDescriptorUpdateTemplate> objectUpdateTemplate;
+        std::vector<VkDrawIndexedIndirectCommand> drawCommands;
+
+        // Object data of every slot, persistent across frames. A changed slot is queued for each
+        // frame's buffer and written the next time that frame is recorded; bit i of
+        // queuedObjectFrames marks the slot as queued for frame i.
+        std::vector<ObjectData> objectData;
+        std::vector<uint32_t> queuedObjectFrames;
+        std::vector<std::vector<uint32_t>> queuedObjectWrites;
     };
 }
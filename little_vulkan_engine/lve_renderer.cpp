@@ -9,21 +9,34 @@ namespace lve
     LveRenderer::LveRenderer(LveWindow &window, LveDevice &device)
         : lveWindow{window}, lveDevice{device}
     {
-        recreateSwapChain();
+        // constructed on the event thread, which may block until the window has an area
+        while (!recreateSwapChain())
+        {
+            lveWindow.waitEvents();
+        }
         createCommandBuffers();
+        if (lveDevice.getFrameConfig().presentThread)
+        {
+            this->presentThread = std::make_unique<LvePresentThread>();
+        }
     }
 
-    LveRenderer::~LveRenderer() { this->freeCommandBuffers(); }
+    LveRenderer::~LveRenderer()
+    {
+        // joins before the swap chain goes away
+        this->presentThread.reset();
+        this->freeCommandBuffers();
+    }
 
-    void LveRenderer::recreateSwapChain()
+    bool LveRenderer::recreateSwapChain()
     {
+        // never waits for window events, the caller may not be the thread that pumps them
         auto extent = lveWindow.getExtent();
-        while (extent.width == 0 || extent.height == 0)
+        if (extent.width == 0 || extent.height == 0)
         {
-            extent = lveWindow.getExtent();
-            glfwWaitEvents();
+            this->swapChainStale = true;
+            return false;
         }
-        vkDeviceWaitIdle(lveDevice.device());
 
         if (lveSwapChain == nullptr)
         {
@@ -31,17 +44,30 @@ namespace lve
         }
         else
         {
+            // no device idle, the old swap chain is destroyed once its frames have finished
             std::shared_ptr<LveSwapChain> oldSwapChain = std::move(this->lveSwapChain);
             lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, oldSwapChain);
             if (!oldSwapChain->compareSwapFormats(*this->lveSwapChain.get())) {
                 throw std::runtime_error("swap chain image or depth format has change");
             }
+            lveDevice.deferDestroy([oldSwapChain]() mutable { oldSwapChain.reset(); });
         }
+
+        this->swapChainStale = false;
+        return true;
     }
 
+    bool LveRenderer::isSwapChainExtentStale() const
+    {
+        VkExtent2D extent = lveWindow.getExtent();
+        VkExtent2D swapChainExtent = lveSwapChain->getSwapChainExtent();
+        return extent.width != swapChainExtent.width || extent.height != swapChainExtent.height;
+    }
+
+
     void LveRenderer::createCommandBuffers()
     {
-        this->commandBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        this->commandBuffers.resize(this->lveDevice.getFramesInFlight());
 
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -65,23 +91,68 @@ namespace lve
         commandBuffers.clear();
     }
 
+    VkResult LveRenderer::acquireNextImage()
+    {
+        if (this->presentThread == nullptr)
+        {
+            return lveSwapChain->acquireNextImage(&currentImageIndex);
+        }
+
+        if (!this->acquireRequested)
+        {
+            this->presentThread->requestAcquire(*lveSwapChain);
+        }
+        LvePresentThread::Acquired acquired = this->presentThread->waitAcquired();
+        this->acquireRequested = false;
+
+        if (acquired.presentResult != VK_SUCCESS && acquired.presentResult != VK_ERROR_OUT_OF_DATE_KHR &&
+            acquired.presentResult != VK_SUBOPTIMAL_KHR)
+        {
+            throw std::runtime_error("failed to present swap chain image!");
+        }
+
+        // nothing was acquired when the last present found the swap chain stale
+        currentImageIndex = acquired.imageIndex;
+        return acquired.acquireResult;
+    }
+
     VkCommandBuffer LveRenderer::beginFrame()
     {
         assert(!isFrameStarted && "cant call beginFrame while already in progress");
 
-        VkResult result = lveSwapChain->acquireNextImage(&currentImageIndex);
-        if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        if (this->swapChainStale && !this->recreateSwapChain())
         {
-            this->recreateSwapChain();
             return nullptr;
         }
 
+        VkResult result = this->acquireNextImage();
+        if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            // recreate and try again right away instead of dropping the frame
+            if (!this->recreateSwapChain())
+            {
+                return nullptr;
+            }
+            result = this->acquireNextImage();
+            if (result == VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                return nullptr;
+            }
+        }
+
         if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
         {
             throw std::runtime_error("failed to acquire swap chain image!");
         }
 
         isFrameStarted = true;
+        // acquiring waited on the timeline value of the frame that last used this frame slot
+        uint64_t frame = lveDevice.getCurrentFrame();
+        uint32_t framesInFlight = lveDevice.getFramesInFlight();
+        if (frame + 1 >= framesInFlight)
+        {
+            lveDevice.completeFrames(frame + 1 - framesInFlight);
+        }
 
         VkCommandBuffer commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
@@ -103,20 +174,38 @@ namespace lve
             throw std::runtime_error("failed to record command buffer!");
         }
 
-        VkResult result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
-        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
-            lveWindow.wasWindowResized())
+        // a window drag fires many resize events, they are coalesced into at most one
+        // recreation per frame and only when the size actually differs from the swap chain
+        bool resized = lveWindow.wasWindowResized();
+        lveWindow.resetWindowResizedFlag();
+        bool stale = resized && this->isSwapChainExtentStale();
+
+        if (this->presentThread != nullptr)
         {
-            lveWindow.resetWindowResizedFlag();
-            recreateSwapChain();
+            // present and the next acquire run on the present thread while the caller goes on
+            // with the next frame, beginFrame recreates the swap chain once that reported it stale
+            lveSwapChain->submit(&commandBuffer, currentImageIndex);
+            lveDevice.endFrame();
+            this->presentThread->requestPresent(*lveSwapChain, currentImageIndex, !stale);
+            this->acquireRequested = true;
         }
-        else if (result != VK_SUCCESS)
+        else
         {
-            throw std::runtime_error("failed to present swap chain image!");
+            VkResult result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+            lveDevice.endFrame();
+
+            if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || stale)
+            {
+                recreateSwapChain();
+            }
+            else if (result != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to present swap chain image!");
+            }
         }
 
         isFrameStarted = false;
-        this->currentFrameIndex = (this->currentFrameIndex + 1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+        this->currentFrameIndex = (this->currentFrameIndex + 1) % this->lveDevice.getFramesInFlight();
     }
 
     void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
@@ -124,21 +213,28 @@ namespace lve
         assert(isFrameStarted && "cant call beginSwapChainRenderPass if frame is not in progress");
         assert(commandBuffer == getCurrentCommandBuffer() && "cant begin render pass on command buffer from a different frame");
 
-        VkRenderPassBeginInfo renderPassInfo{};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = lveSwapChain->getRenderPass();
-        renderPassInfo.framebuffer = lveSwapChain->getFrameBuffer(currentImageIndex);
+        if (lveSwapChain->usesDynamicRendering())
+        {
+            this->beginDynamicRendering(commandBuffer);
+        }
+        else
+        {
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass = lveSwapChain->getRenderPass();
+            renderPassInfo.framebuffer = lveSwapChain->getFrameBuffer(currentImageIndex);
 
-        renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = lveSwapChain->getSwapChainExtent();
+            renderPassInfo.renderArea.offset = {0, 0};
+            renderPassInfo.renderArea.extent = lveSwapChain->getSwapChainExtent();
 
-        std::array<VkClearValue, 2> clearValues{};
-        clearValues[0].color = {0.01f, 0.01f, 0.01f, 1.0f};
-        clearValues[1].depthStencil = {1.0f, 0};
-        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-        renderPassInfo.pClearValues = clearValues.data();
+            std::array<VkClearValue, 2> clearValues{};
+            clearValues[0].color = {0.01f, 0.01f, 0.01f, 1.0f};
+            clearValues[1].depthStencil = {1.0f, 0};
+            renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+            renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        }
 
         VkViewport viewport{};
         viewport.x = 0.0f;
@@ -156,6 +252,116 @@ namespace lve
     {
         assert(isFrameStarted && "cant call endSwapChainRenderPass if frame is not in progress");
         assert(commandBuffer == getCurrentCommandBuffer() && "cant end render pass on command buffer from a different frame");
-        vkCmdEndRenderPass(commandBuffer);
+
+        if (lveSwapChain->usesDynamicRendering())
+        {
+            this->endDynamicRendering(commandBuffer);
+        }
+        else
+        {
+            vkCmdEndRenderPass(commandBuffer);
+        }
+    }
+
+    void LveRenderer::beginDynamicRendering(VkCommandBuffer commandBuffer)
+    {
+        // the layout transitions the render pass did implicitly, both images are cleared so
+        // their previous contents can be discarded
+        VkFormat depthFormat = lveSwapChain->getSwapChainDepthFormat();
+        VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        if (depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || depthFormat == VK_FORMAT_D24_UNORM_S8_UINT)
+        {
+            depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+        }
+
+        std::array<VkImageMemoryBarrier, 2> barriers{};
+        barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[0].srcAccessMask = 0;
+        barriers[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].image = lveSwapChain->getImage(currentImageIndex);
+        barriers[0].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+        barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[1].dstAccessMask =
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].image = lveSwapChain->getDepthImage(currentImageIndex);
+        barriers[1].subresourceRange = {depthAspect, 0, 1, 0, 1};
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            static_cast<uint32_t>(barriers.size()),
+            barriers.data());
+
+        VkRenderingAttachmentInfoKHR colorAttachment{};
+        colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+        colorAttachment.imageView = lveSwapChain->getImageView(currentImageIndex);
+        colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.clearValue.color = {0.01f, 0.01f, 0.01f, 1.0f};
+
+        VkRenderingAttachmentInfoKHR depthAttachment{};
+        depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+        depthAttachment.imageView = lveSwapChain->getDepthImageView(currentImageIndex);
+        depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.clearValue.depthStencil = {1.0f, 0};
+
+        VkRenderingInfoKHR renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+        renderingInfo.renderArea.offset = {0, 0};
+        renderingInfo.renderArea.extent = lveSwapChain->getSwapChainExtent();
+        renderingInfo.layerCount = 1;
+        renderingInfo.colorAttachmentCount = 1;
+        renderingInfo.pColorAttachments = &colorAttachment;
+        renderingInfo.pDepthAttachment = &depthAttachment;
+
+        lveDevice.dynamicRendering.cmdBeginRendering(commandBuffer, &renderingInfo);
+    }
+
+    void LveRenderer::endDynamicRendering(VkCommandBuffer commandBuffer)
+    {
+        lveDevice.dynamicRendering.cmdEndRendering(commandBuffer);
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = lveSwapChain->getImage(currentImageIndex);
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            1,
+            &barrier);
     }
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "lve_device.hpp"
+#include "lve_pipeline.hpp"
+#include "lve_present_thread.hpp"
 #include "lve_swap_chain.hpp"
 #include "lve_window.hpp"
 
@@ -19,7 +21,16 @@ namespace lve
         LveRenderer(const LveRenderer &) = delete;
         LveRenderer &operator=(const LveRenderer &) = delete;
 
+        // null when rendering with VK_KHR_dynamic_rendering
         VkRenderPass getSwapChainRenderPass() const { return lveSwapChain->getRenderPass(); }
+        // stays valid across swap chain recreation, pipelines may keep it
+        PipelineRenderTarget getSwapChainRenderTarget() const
+        {
+            return {
+                lveSwapChain->getRenderPass(),
+                lveSwapChain->getSwapChainImageFormat(),
+                lveSwapChain->getSwapChainDepthFormat()};
+        }
         float getAspectRatio() const { return lveSwapChain->extentAspectRatio(); }
         bool isFrameInProgress() const { return isFrameStarted; }
 
@@ -35,6 +46,7 @@ namespace lve
             return currentFrameIndex;
         }
 
+        // null when no frame can be rendered right now, e.g. while the window is minimized
         VkCommandBuffer beginFrame();
         void endFrame();
 
@@ -44,12 +56,23 @@ namespace lve
     private:
         void createCommandBuffers();
         void freeCommandBuffers();
-        void recreateSwapChain();
+        // false while the window has no area, the swap chain stays stale until a later attempt
+        bool recreateSwapChain();
+        VkResult acquireNextImage();
+        bool isSwapChainExtentStale() const;
+        void beginDynamicRendering(VkCommandBuffer commandBuffer);
+        void endDynamicRendering(VkCommandBuffer commandBuffer);
 
         LveWindow &lveWindow;
         LveDevice &lveDevice;
         std::unique_ptr<LveSwapChain> lveSwapChain;
         std::vector<VkCommandBuffer> commandBuffers;
+        // null unless FrameConfig::presentThread is set
+        std::unique_ptr<LvePresentThread> presentThread;
+        // the present thread owes an acquired image for a request sent in endFrame
+        bool acquireRequested{false};
+        // the swap chain is out of date but could not be recreated yet
+        bool swapChainStale{false};
 
         uint32_t currentImageIndex;
         int currentFrameIndex{0};
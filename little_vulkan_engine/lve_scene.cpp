@@ -0,0 +1,79 @@
+#include "lve_scene.hpp"
+
+namespace lve
+{
+    LveScene::id_t LveScene::createEntity()
+    {
+        assert(this->nextId != LveComponentPool<TransformComponent>::INVALID_INDEX && "entity ids exhausted");
+        id_t id = this->nextId++;
+        this->transforms.emplace(id);
+
+        return id;
+    }
+
+    LveScene::id_t LveScene::createPointLight(float intensity, float radius, glm::vec3 color)
+    {
+        id_t id = this->createEntity();
+        TransformComponent &transform = this->transforms.get(id);
+        transform.setScale({radius, transform.getScale().y, transform.getScale().z});
+        this->pointLights.emplace(id, intensity, color);
+
+        return id;
+    }
+
+    void LveScene::destroyEntity(LveScene::id_t id)
+    {
+        if (!this->isAlive(id))
+        {
+            return;
+        }
+
+        this->transforms.remove(id);
+        this->models.remove(id);
+        this->pointLights.remove(id);
+        this->pendingDestroyedEntities.push_back(id);
+    }
+
+    ModelComponent &LveScene::setModel(LveScene::id_t id, std::shared_ptr<LveModel> model, bool isStatic)
+    {
+        assert(this->isAlive(id) && "setting the model of a destroyed entity");
+        this->transforms.get(id).markDirty();
+
+        ModelComponent *component = this->models.find(id);
+        if (component == nullptr)
+        {
+            return this->models.emplace(id, std::move(model), isStatic);
+        }
+
+        component->model = std::move(model);
+        component->isStatic = isStatic;
+        return *component;
+    }
+
+    void LveScene::updateTransforms(LveJobSystem &jobSystem)
+    {
+        this->destroyedEntities.swap(this->pendingDestroyedEntities);
+        this->pendingDestroyedEntities.clear();
+
+        this->dirtyTransforms.clear();
+        const std::vector<id_t> &ids = this->transforms.getIds();
+        const std::vector<TransformComponent> &components = this->transforms.getComponents();
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            if (components[i].isDirty())
+            {
+                this->dirtyTransforms.push_back(ids[i]);
+            }
+        }
+
+        jobSystem.parallelFor(
+            static_cast<uint32_t>(this->dirtyTransforms.size()),
+            TRANSFORM_UPDATE_GRAIN,
+            [this](uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    this->transforms.get(this->dirtyTransforms[i]).update();
+                }
+            });
+    }
+}
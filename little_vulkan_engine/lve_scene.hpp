@@ -0,0 +1,128 @@
+#pragma once
+
+#include "lve_game_object.hpp"
+#include "lve_job_system.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace lve
+{
+    // Sparse set of one component type. Components are packed densely in insertion order, with
+    // the owning entity id at the same index, so systems iterate a contiguous array. A sparse
+    // array indexed by entity id maps back into it for constant time lookup. Removal moves the
+    // last component into the hole, adding or removing invalidates references into the pool.
+    template <typename T>
+    class LveComponentPool
+    {
+    public:
+        using id_t = uint32_t;
+        static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+        template <typename... Args>
+        T &emplace(id_t id, Args &&...args)
+        {
+            assert(!this->contains(id) && "entity already has this component");
+            if (id >= this->sparse.size())
+            {
+                this->sparse.resize(static_cast<size_t>(id) + 1, INVALID_INDEX);
+            }
+
+            this->sparse[id] = static_cast<uint32_t>(this->dense.size());
+            this->dense.push_back(id);
+            this->components.push_back(T{std::forward<Args>(args)...});
+            return this->components.back();
+        }
+
+        void remove(id_t id)
+        {
+            if (!this->contains(id))
+            {
+                return;
+            }
+
+            uint32_t index = this->sparse[id];
+            id_t last = this->dense.back();
+            this->dense[index] = last;
+            this->components[index] = std::move(this->components.back());
+            this->sparse[last] = index;
+
+            this->dense.pop_back();
+            this->components.pop_back();
+            this->sparse[id] = INVALID_INDEX;
+        }
+
+        bool contains(id_t id) const { return id < this->sparse.size() && this->sparse[id] != INVALID_INDEX; }
+
+        T &get(id_t id)
+        {
+            assert(this->contains(id) && "entity does not have this component");
+            return this->components[this->sparse[id]];
+        }
+
+        const T &get(id_t id) const
+        {
+            assert(this->contains(id) && "entity does not have this component");
+            return this->components[this->sparse[id]];
+        }
+
+        T *find(id_t id) { return this->contains(id) ? &this->components[this->sparse[id]] : nullptr; }
+        const T *find(id_t id) const { return this->contains(id) ? &this->components[this->sparse[id]] : nullptr; }
+
+        size_t size() const { return dense.size(); }
+        // entity ids, parallel to getComponents
+        const std::vector<id_t> &getIds() const { return dense; }
+        std::vector<T> &getComponents() { return components; }
+        const std::vector<T> &getComponents() const { return components; }
+
+    private:
+        std::vector<uint32_t> sparse{};
+        std::vector<id_t> dense{};
+        std::vector<T> components{};
+    };
+
+    // Game objects are ids with their components kept in one pool per type. Every entity has a
+    // transform; systems iterate the pool of the component they care about and look the others
+    // up by id. Ids are not reused, so a stale id never aliases a newer entity.
+    class LveScene
+    {
+    public:
+        using id_t = uint32_t;
+        // transforms recomputed per job
+        static constexpr uint32_t TRANSFORM_UPDATE_GRAIN = 256;
+
+        LveScene() = default;
+
+        LveScene(const LveScene &) = delete;
+        LveScene &operator=(const LveScene &) = delete;
+
+        id_t createEntity();
+        id_t createPointLight(float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
+        void destroyEntity(id_t id);
+        // Adds or replaces the model of an entity and reports it with the changed transforms.
+        // Editing the model pool directly bypasses that, systems following changes miss it.
+        ModelComponent &setModel(id_t id, std::shared_ptr<LveModel> model, bool isStatic = false);
+        bool isAlive(id_t id) const { return transforms.contains(id); }
+        size_t size() const { return transforms.size(); }
+
+        // Recomputes the matrices of every transform changed since the last call. The ids of those
+        // transforms and of the entities destroyed since the last call stay available until the
+        // next call, for systems that only follow changes.
+        void updateTransforms(LveJobSystem &jobSystem);
+        const std::vector<id_t> &getDirtyTransforms() const { return dirtyTransforms; }
+        const std::vector<id_t> &getDestroyedEntities() const { return destroyedEntities; }
+
+        LveComponentPool<TransformComponent> transforms{};
+        LveComponentPool<ModelComponent> models{};
+        LveComponentPool<PointLightComponent> pointLights{};
+
+    private:
+        id_t nextId = 0;
+        std::vector<id_t> dirtyTransforms{};
+        std::vector<id_t> destroyedEntities{};
+        std::vector<id_t> pendingDestroyedEntities{};
+    };
+}
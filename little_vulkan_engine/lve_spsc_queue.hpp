@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace lve
+{
+    // Lock-free queue between exactly one producer and one consumer thread. Each index is only
+    // written by one side, acquire/release ordering on it publishes the slots to the other.
+    template <typename T>
+    class LveSpscQueue
+    {
+    public:
+        // spins before a waiting side starts yielding and finally sleeping
+        static constexpr int SPIN_COUNT = 256;
+
+        explicit LveSpscQueue(size_t capacity) : slots(capacity + 1) {}
+
+        LveSpscQueue(const LveSpscQueue &) = delete;
+        LveSpscQueue &operator=(const LveSpscQueue &) = delete;
+
+        bool tryPush(const T &value)
+        {
+            size_t currentTail = this->tail.load(std::memory_order_relaxed);
+            size_t nextTail = (currentTail + 1) % this->slots.size();
+            if (nextTail == this->head.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            this->slots[currentTail] = value;
+            this->tail.store(nextTail, std::memory_order_release);
+            return true;
+        }
+
+        bool tryPop(T &value)
+        {
+            size_t currentHead = this->head.load(std::memory_order_relaxed);
+            if (currentHead == this->tail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            value = this->slots[currentHead];
+            this->head.store((currentHead + 1) % this->slots.size(), std::memory_order_release);
+            return true;
+        }
+
+        // block until the other side made room or pushed a value
+        void push(const T &value)
+        {
+            for (int spins = 0; !this->tryPush(value); backoff(spins)) {}
+        }
+
+        T pop()
+        {
+            T value{};
+            for (int spins = 0; !this->tryPop(value); backoff(spins)) {}
+            return value;
+        }
+
+    private:
+        static void backoff(int &spins)
+        {
+            if (spins < SPIN_COUNT)
+            {
+                spins++;
+            }
+            else if (spins < 2 * SPIN_COUNT)
+            {
+                spins++;
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+
+        std::vector<T> slots;
+        // on separate cache lines, the producer writes tail and the consumer head
+        alignas(64) std::atomic<size_t> head{0};
+        alignas(64) std::atomic<size_t> tail{0};
+    };
+}
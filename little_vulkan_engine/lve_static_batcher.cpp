@@ -0,0 +1,165 @@
+#include "lve_static_batcher.hpp"
+#include "lve_utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace lve
+{
+    size_t LveStaticBatcher::CellKeyHash::operator()(const CellKey &key) const
+    {
+        size_t seed = 0;
+        hashCombine(seed, key.x, key.y, key.z);
+
+        return seed;
+    }
+
+    LveStaticBatcher::LveStaticBatcher(LveGeometryPool &geometryPool, float cellSize)
+        : geometryPool{geometryPool}, cellSize{cellSize}
+    {
+        assert(cellSize > 0.f && "static batch cell size must be positive");
+    }
+
+    LveStaticBatcher::~LveStaticBatcher() {}
+
+    LveStaticBatcher::CellKey LveStaticBatcher::cellKeyFor(const glm::vec3 &position) const
+    {
+        return CellKey{
+            static_cast<int>(std::floor(position.x / this->cellSize)),
+            static_cast<int>(std::floor(position.y / this->cellSize)),
+            static_cast<int>(std::floor(position.z / this->cellSize))};
+    }
+
+    void LveStaticBatcher::markDirty(const CellKey &key, Cell &cell)
+    {
+        if (!cell.dirty)
+        {
+            cell.dirty = true;
+            this->dirtyCells.push_back(key);
+        }
+    }
+
+    void LveStaticBatcher::removeObject(LveScene::id_t id)
+    {
+        auto batched = this->batchedObjects.find(id);
+        if (batched == this->batchedObjects.end())
+        {
+            return;
+        }
+
+        Cell &cell = this->cells.at(batched->second);
+        cell.members.erase(id);
+        this->markDirty(batched->second, cell);
+        this->batchedObjects.erase(batched);
+    }
+
+    void LveStaticBatcher::update(const LveScene &scene)
+    {
+        this->dirtyCells.clear();
+        for (LveScene::id_t id : scene.getDestroyedEntities())
+        {
+            this->removeObject(id);
+        }
+
+        // new, moved or re-modelled objects all show up as changed transforms
+        for (LveScene::id_t id : scene.getDirtyTransforms())
+        {
+            const ModelComponent *obj = scene.models.find(id);
+            if (obj == nullptr || !canBatch(*obj))
+            {
+                // no longer static or lost its model
+                this->removeObject(id);
+                continue;
+            }
+
+            const TransformComponent &transform = scene.transforms.get(id);
+            CellKey key = this->cellKeyFor(transform.getTranslation());
+            auto previous = this->batchedObjects.find(id);
+            if (previous != this->batchedObjects.end() && !(previous->second == key))
+            {
+                this->removeObject(id);
+            }
+            this->batchedObjects[id] = key;
+
+            Cell &cell = this->cells[key];
+            cell.members[id] = Member{obj->model, transform};
+            this->markDirty(key, cell);
+        }
+
+        if (this->dirtyCells.empty())
+        {
+            return;
+        }
+
+        for (const CellKey &key : this->dirtyCells)
+        {
+            auto it = this->cells.find(key);
+            if (it->second.members.empty())
+            {
+                this->cells.erase(it);
+            }
+            else
+            {
+                this->rebuildCell(it->second);
+            }
+        }
+
+        this->batches.clear();
+        for (const auto &kv : this->cells)
+        {
+            this->batches.push_back(&kv.second.batch);
+        }
+    }
+
+    void LveStaticBatcher::rebuildCell(Cell &cell)
+    {
+        this->merged.vertices.clear();
+        this->merged.indices.clear();
+        glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+        glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+
+        for (std::pair<const LveScene::id_t, Member> &kv : cell.members)
+        {
+            Member &member = kv.second;
+            const LveModel::Builder &mesh = *member.model->getMeshCache();
+            const glm::mat4 modelMatrix = member.transform.mat4();
+            const glm::mat3 normalMatrix = member.transform.normalMatrix();
+            const uint32_t baseVertex = static_cast<uint32_t>(this->merged.vertices.size());
+
+            for (const LveModel::Vertex &vertex : mesh.vertices)
+            {
+                LveModel::Vertex transformed = vertex;
+                transformed.position = glm::vec3(modelMatrix * glm::vec4(vertex.position, 1.f));
+                transformed.normal = glm::normalize(normalMatrix * vertex.normal);
+                this->merged.vertices.push_back(transformed);
+
+                boundsMin = glm::min(boundsMin, transformed.position);
+                boundsMax = glm::max(boundsMax, transformed.position);
+            }
+
+            if (mesh.indices.empty())
+            {
+                for (uint32_t i = 0; i < mesh.vertices.size(); i++)
+                {
+                    this->merged.indices.push_back(baseVertex + i);
+                }
+            }
+            else
+            {
+                for (uint32_t index : mesh.indices)
+                {
+                    this->merged.indices.push_back(baseVertex + index);
+                }
+            }
+        }
+
+        // replacing the model frees the old batch through the pool's deferred free
+        cell.batch.model = std::make_unique<LveModel>(this->geometryPool, this->merged);
+        cell.batch.boundsMin = boundsMin;
+        cell.batch.boundsMax = boundsMax;
+        cell.dirty = false;
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "lve_geometry_pool.hpp"
+#include "lve_model.hpp"
+#include "lve_scene.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace lve
+{
+    // Merges the meshes of static game objects into pre-transformed batches, one per cell of a
+    // uniform grid, so static scenery costs one draw per visible cell and no per frame transform
+    // work. Batches keep world space bounds for culling and are rebuilt only when an object in
+    // their cell is added, moved, changes model or is removed.
+    //
+    // Only objects whose model keeps a cpu side mesh cache (models from LveModelRegistry) can be
+    // batched; other static objects are left to be drawn individually.
+    class LveStaticBatcher
+    {
+    public:
+        static constexpr float DEFAULT_CELL_SIZE = 8.f;
+
+        struct Batch
+        {
+            std::unique_ptr<LveModel> model;
+            glm::vec3 boundsMin{0.f};
+            glm::vec3 boundsMax{0.f};
+        };
+
+        LveStaticBatcher(LveGeometryPool &geometryPool, float cellSize = DEFAULT_CELL_SIZE);
+        ~LveStaticBatcher();
+
+        LveStaticBatcher(const LveStaticBatcher &) = delete;
+        LveStaticBatcher &operator=(const LveStaticBatcher &) = delete;
+
+        // Follows the transforms the scene reports as changed and the entities it reports as
+        // destroyed, and rebuilds only the batches of cells they touched. Call after every
+        // LveScene::updateTransforms, before rendering.
+        void update(const LveScene &scene);
+
+        // whether update puts the object into a batch, false leaves it to be drawn on its own
+        static bool canBatch(const ModelComponent &obj)
+        {
+            return obj.isStatic && obj.model != nullptr && obj.model->getMeshCache() != nullptr;
+        }
+        bool isBatched(LveScene::id_t id) const { return batchedObjects.count(id) != 0; }
+        const std::vector<const Batch *> &getBatches() const { return batches; }
+
+    private:
+        struct CellKey
+        {
+            int x;
+            int y;
+            int z;
+
+            bool operator==(const CellKey &other) const
+            {
+                return x == other.x && y == other.y && z == other.z;
+            }
+        };
+
+        struct CellKeyHash
+        {
+            size_t operator()(const CellKey &key) const;
+        };
+
+        // snapshot of a member object as it was when its cell was last built
+        struct Member
+        {
+            std::shared_ptr<LveModel> model;
+            TransformComponent transform;
+        };
+
+        struct Cell
+        {
+            std::unordered_map<LveScene::id_t, Member> members{};
+            Batch batch{};
+            // listed in dirtyCells
+            bool dirty = false;
+        };
+
+        CellKey cellKeyFor(const glm::vec3 &position) const;
+        void markDirty(const CellKey &key, Cell &cell);
+        void removeObject(LveScene::id_t id);
+        void rebuildCell(Cell &cell);
+
+        LveGeometryPool &geometryPool;
+        float cellSize;
+
+        std::unordered_map<CellKey, Cell, CellKeyHash> cells{};
+        std::unordered_map<LveScene::id_t, CellKey> batchedObjects{};
+        std::vector<const Batch *> batches{};
+
+        // scratch kept across updates
+        std::vector<CellKey> dirtyCells{};
+        LveModel::Builder merged{};
+    };
+}
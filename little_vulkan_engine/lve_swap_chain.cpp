@@ -10,6 +10,24 @@
 
 namespace lve
 {
+    namespace
+    {
+        const char *presentModeName(VkPresentModeKHR presentMode)
+        {
+            switch (presentMode)
+            {
+            case VK_PRESENT_MODE_IMMEDIATE_KHR:
+                return "Immediate";
+            case VK_PRESENT_MODE_MAILBOX_KHR:
+                return "Mailbox";
+            case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+                return "Relaxed V-Sync";
+            default:
+                return "V-Sync";
+            }
+        }
+    }
+
     LveSwapChain::LveSwapChain(LveDevice &deviceRef, VkExtent2D extent)
         : device{deviceRef}, windowExtent{extent}
     {
@@ -26,10 +44,36 @@ namespace lve
     void LveSwapChain::init() {
         createSwapChain();
         createImageViews();
-        createRenderPass();
+        // with dynamic rendering there is neither a render pass nor framebuffers to rebuild
+        if (!device.dynamicRendering.supported)
+        {
+            // Pipelines were built against the render pass of the first swap chain. It is handed
+            // on as long as the format stays the same, so the handle outlives every recreation.
+            if (this->oldSwapChain != nullptr && this->oldSwapChain->renderPass != VK_NULL_HANDLE &&
+                this->oldSwapChain->swapChainImageFormat == this->swapChainImageFormat)
+            {
+                this->renderPass = this->oldSwapChain->renderPass;
+                this->oldSwapChain->renderPass = VK_NULL_HANDLE;
+            }
+            else
+            {
+                createRenderPass();
+            }
+        }
         createDepthResources();
-        createFramebuffers();
-        createSyncObjects();
+        if (!device.dynamicRendering.supported)
+        {
+            createFramebuffers();
+        }
+
+        if (this->oldSwapChain == nullptr)
+        {
+            createSyncObjects();
+        }
+        else
+        {
+            adoptSyncObjects(*this->oldSwapChain);
+        }
     }
 
     LveSwapChain::~LveSwapChain()
@@ -61,22 +105,20 @@ namespace lve
         vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
         // cleanup synchronization objects
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        // empty when a newer swap chain took them over
+        for (size_t i = 0; i < imageAvailableSemaphores.size(); i++)
         {
             vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
             vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-            vkDestroyFence(device.device(), inFlightFences[i], nullptr);
         }
     }
 
     VkResult LveSwapChain::acquireNextImage(uint32_t *imageIndex)
     {
-        vkWaitForFences(
-            device.device(),
-            1,
-            &inFlightFences[currentFrame],
-            VK_TRUE,
-            std::numeric_limits<uint64_t>::max());
+        // the previous frame in this slot has to finish before its resources are reused. The
+        // image itself needs no wait, its acquire semaphore only signals once presentation of
+        // the frame that rendered to it, and with that the rendering, is done.
+        device.waitForTimeline(frameTimelineValues[currentFrame]);
 
         VkResult result = vkAcquireNextImageKHR(
             device.device(),
@@ -92,12 +134,12 @@ namespace lve
     VkResult LveSwapChain::submitCommandBuffers(
         const VkCommandBuffer *buffers, uint32_t *imageIndex)
     {
-        if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE)
-        {
-            vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
-        }
-        imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
+        this->submit(buffers, *imageIndex);
+        return this->present(*imageIndex);
+    }
 
+    void LveSwapChain::submit(const VkCommandBuffer *buffers, uint32_t imageIndex)
+    {
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
@@ -114,12 +156,12 @@ namespace lve
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
-        vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-            VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to submit draw command buffer!");
-        }
+        frameTimelineValues[currentFrame] = device.submit(submitInfo);
+    }
+
+    VkResult LveSwapChain::present(uint32_t imageIndex)
+    {
+        VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
 
         VkPresentInfoKHR presentInfo = {};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -131,11 +173,11 @@ namespace lve
         presentInfo.swapchainCount = 1;
         presentInfo.pSwapchains = swapChains;
 
-        presentInfo.pImageIndices = imageIndex;
+        presentInfo.pImageIndices = &imageIndex;
 
-        auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+        auto result = device.present(presentInfo);
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        currentFrame = (currentFrame + 1) % frameTimelineValues.size();
 
         return result;
     }
@@ -145,10 +187,11 @@ namespace lve
         SwapChainSupportDetails swapChainSupport = this->device.getSwapChainSupport();
 
         VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+        this->presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
         VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-        uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+        uint32_t imageCount =
+            swapChainSupport.capabilities.minImageCount + this->device.getFrameConfig().extraSwapChainImages;
         if (swapChainSupport.capabilities.maxImageCount > 0 &&
             imageCount > swapChainSupport.capabilities.maxImageCount)
         {
@@ -185,7 +228,7 @@ namespace lve
         createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
         createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 
-        createInfo.presentMode = presentMode;
+        createInfo.presentMode = this->presentMode;
         createInfo.clipped = VK_TRUE;
 
         createInfo.oldSwapchain = this->oldSwapChain == nullptr ? VK_NULL_HANDLE : this->oldSwapChain->swapChain;
@@ -376,31 +419,40 @@ namespace lve
 
     void LveSwapChain::createSyncObjects()
     {
-        imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+        uint32_t framesInFlight = getFramesInFlight();
+        imageAvailableSemaphores.resize(framesInFlight);
+        renderFinishedSemaphores.resize(framesInFlight);
+        // 0 is the timeline's initial value, the first wait of each slot returns right away
+        frameTimelineValues.assign(framesInFlight, 0);
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-        VkFenceCreateInfo fenceInfo = {};
-        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        for (size_t i = 0; i < framesInFlight; i++)
         {
             if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
                     VK_SUCCESS ||
                 vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
-                    VK_SUCCESS ||
-                vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
+                    VK_SUCCESS)
             {
                 throw std::runtime_error("failed to create synchronization objects for a frame!");
             }
         }
     }
 
+    void LveSwapChain::adoptSyncObjects(LveSwapChain &previous)
+    {
+        // the timeline values still guard frames recorded for the previous swap chain, and none
+        // of the semaphores has a pending signal once acquire or present reported the chain stale
+        imageAvailableSemaphores = std::move(previous.imageAvailableSemaphores);
+        renderFinishedSemaphores = std::move(previous.renderFinishedSemaphores);
+        frameTimelineValues = std::move(previous.frameTimelineValues);
+        currentFrame = previous.currentFrame;
+        previous.imageAvailableSemaphores.clear();
+        previous.renderFinishedSemaphores.clear();
+        previous.frameTimelineValues.clear();
+    }
+
     VkSurfaceFormatKHR LveSwapChain::chooseSwapSurfaceFormat(
         const std::vector<VkSurfaceFormatKHR> &availableFormats)
     {
@@ -419,22 +471,18 @@ namespace lve
     VkPresentModeKHR LveSwapChain::chooseSwapPresentMode(
         const std::vector<VkPresentModeKHR> &availablePresentModes)
     {
-        for (const auto &availablePresentMode : availablePresentModes)
+        for (VkPresentModeKHR preferredMode : this->device.getFrameConfig().presentModes)
         {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+            for (const auto &availablePresentMode : availablePresentModes)
             {
-                std::cout << "Present mode: Mailbox" << std::endl;
-                return availablePresentMode;
+                if (availablePresentMode == preferredMode)
+                {
+                    std::cout << "Present mode: " << presentModeName(preferredMode) << std::endl;
+                    return availablePresentMode;
+                }
             }
         }
 
-        // for (const auto &availablePresentMode : availablePresentModes) {
-        //   if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-        //     std::cout << "Present mode: Immediate" << std::endl;
-        //     return availablePresentMode;
-        //   }
-        // }
-
         std::cout << "Present mode: V-Sync" << std::endl;
         return VK_PRESENT_MODE_FIFO_KHR;
     }
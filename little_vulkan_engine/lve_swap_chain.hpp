@@ -13,19 +13,28 @@ namespace lve
     class LveSwapChain
     {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
         LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent);
+        // Takes over the frame synchronization objects of previous, so frames keep flowing
+        // across the recreation without waiting for the device to idle
         LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent, std::shared_ptr<LveSwapChain> previous);
         ~LveSwapChain();
 
         LveSwapChain(const LveSwapChain &) = delete;
         LveSwapChain &operator=(const LveSwapChain &) = delete;
 
+        // both are null with dynamic rendering, render into the images and views directly. The
+        // render pass is handed on to the next swap chain and stays valid across recreation.
         VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
         VkRenderPass getRenderPass() { return renderPass; }
+        bool usesDynamicRendering() const { return renderPass == VK_NULL_HANDLE; }
+        VkImage getImage(int index) { return swapChainImages[index]; }
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+        VkImage getDepthImage(int index) { return depthImages[index]; }
+        VkImageView getDepthImageView(int index) { return depthImageViews[index]; }
+        VkFormat getSwapChainDepthFormat() { return swapChainDepthFormat; }
         size_t imageCount() { return swapChainImages.size(); }
+        uint32_t getFramesInFlight() const { return device.getFramesInFlight(); }
+        VkPresentModeKHR getPresentMode() const { return presentMode; }
         VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
         VkExtent2D getSwapChainExtent() { return swapChainExtent; }
         uint32_t width() { return swapChainExtent.width; }
@@ -39,6 +48,10 @@ namespace lve
 
         VkResult acquireNextImage(uint32_t *imageIndex);
         VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+        // the two halves of submitCommandBuffers, present may run on another thread as long as
+        // calls stay ordered submit, present, acquireNextImage
+        void submit(const VkCommandBuffer *buffers, uint32_t imageIndex);
+        VkResult present(uint32_t imageIndex);
         bool compareSwapFormats(const LveSwapChain &swapChain) const
         {
             return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
@@ -53,6 +66,7 @@ namespace lve
         void createRenderPass();
         void createFramebuffers();
         void createSyncObjects();
+        void adoptSyncObjects(LveSwapChain &previous);
 
         VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats);
         VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes);
@@ -61,9 +75,10 @@ namespace lve
         VkFormat swapChainImageFormat;
         VkFormat swapChainDepthFormat;
         VkExtent2D swapChainExtent;
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
 
         std::vector<VkFramebuffer> swapChainFramebuffers;
-        VkRenderPass renderPass;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
 
         std::vector<VkImage> depthImages;
         std::vector<VkDeviceMemory> depthImageMemorys;
@@ -79,8 +94,8 @@ namespace lve
 
         std::vector<VkSemaphore> imageAvailableSemaphores;
         std::vector<VkSemaphore> renderFinishedSemaphores;
-        std::vector<VkFence> inFlightFences;
-        std::vector<VkFence> imagesInFlight;
+        // device timeline value signaled by the last submission of each frame slot
+        std::vector<uint64_t> frameTimelineValues;
         size_t currentFrame = 0;
     };
 
@@ -1,9 +1,10 @@
 #include "lve_window.hpp"
+#include <cassert>
 #include <stdexcept>
 
 namespace lve
 {
-    LveWindow::LveWindow(int w, int h, std::string name) : width{w}, height{h}, windowName{name}
+    LveWindow::LveWindow(int w, int h, std::string name) : width{w}, height{h}, eventThread{std::this_thread::get_id()}, windowName{name}
     {
         initWindow();
     }
@@ -33,6 +34,12 @@ namespace lve
         }
     }
 
+    void LveWindow::waitEvents()
+    {
+        assert(std::this_thread::get_id() == this->eventThread && "window events are only processed on the thread that created the window");
+        glfwWaitEvents();
+    }
+
     void LveWindow::framebufferResizeCallback(GLFWwindow *window, int width, int height)
     {
         LveWindow *lveWindow = reinterpret_cast<LveWindow *>(glfwGetWindowUserPointer(window));
@@ -3,7 +3,9 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <atomic>
 #include <string>
+#include <thread>
 
 namespace lve
 {
@@ -23,14 +25,18 @@ namespace lve
         GLFWwindow *getGLFWwindow() const { return window; };
 
         void createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
+        // glfwWaitEvents, only on the thread that created the window and pumps its events
+        void waitEvents();
 
     private:
         static void framebufferResizeCallback(GLFWwindow *window, int width, int height);
         void initWindow();
 
-        int width;
-        int height;
-        bool frameBufferResized = false;
+        // written by the event callback, read by the render thread
+        std::atomic<int> width;
+        std::atomic<int> height;
+        std::atomic<bool> frameBufferResized{false};
+        std::thread::id eventThread;
 
         std::string windowName;
         GLFWwindow *window;
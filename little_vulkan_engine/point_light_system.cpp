@@ -17,10 +17,15 @@ namespace lve
         float radius;
     };
 
-    PointLightSystem::PointLightSystem(LveDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : lveDevice{device}
+    PointLightSystem::PointLightSystem(
+        LveDevice &device,
+        LvePipelineService &pipelineService,
+        const PipelineRenderTarget &renderTarget,
+        VkDescriptorSetLayout globalSetLayout)
+        : lveDevice{device}
     {
         createPipelineLayout(globalSetLayout);
-        createPipeline(renderPass);
+        createPipeline(pipelineService, renderTarget);
     }
 
     PointLightSystem::~PointLightSystem()
@@ -50,7 +55,7 @@ namespace lve
         }
     }
 
-    void PointLightSystem::createPipeline(VkRenderPass renderPass)
+    void PointLightSystem::createPipeline(LvePipelineService &pipelineService, const PipelineRenderTarget &renderTarget)
     {
         assert(this->pipelineLayout != nullptr && "cannot create pipeline before pipeline layout");
 
@@ -60,48 +65,47 @@ namespace lve
 
         pipelineConfig.attributeDescriptions.clear();
         pipelineConfig.bindingDescriptions.clear();
-        pipelineConfig.renderPass = renderPass;
+        LvePipeline::setRenderTarget(pipelineConfig, renderTarget);
         pipelineConfig.pipelineLayout = this->pipelineLayout;
-        this->lvePipeline = std::make_unique<LvePipeline>(
-            this->lveDevice,
+        this->lvePipeline = pipelineService.request(
             "shaders_point/vert.spv",
             "shaders_point/frag.spv",
             pipelineConfig);
     }
 
-    void PointLightSystem::update(FrameInfo &frameInfo, GlobalUbo &ubo) {
-        auto rotateLight = glm::rotate(glm::mat4(1.f), frameInfo.frameTime, {0.f, -1.f, 0.f});
-        int lightIndex = 0;
-        for (auto& kv : frameInfo.gameObjects) {
-            auto& obj = kv.second;
-            if (obj.pointLight == nullptr) continue;
-
-            assert(lightIndex < MAX_LIGHTS && "Point lights exceed maximum specifed");
-
-            obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.f));
+    void PointLightSystem::update(float frameTime, LveScene &scene, LveJobSystem &jobSystem) {
+        const std::vector<LveScene::id_t> &lights = scene.pointLights.getIds();
+        auto rotateLight = glm::rotate(glm::mat4(1.f), frameTime, {0.f, -1.f, 0.f});
+        jobSystem.parallelFor(static_cast<uint32_t>(lights.size()), LIGHT_UPDATE_GRAIN, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                auto& transform = scene.transforms.get(lights[i]);
+                transform.setTranslation(glm::vec3(rotateLight * glm::vec4(transform.getTranslation(), 1.f)));
+            }
+        });
+    }
 
-            ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.f);
-            ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntesity);
+    void PointLightSystem::writeLights(FrameInfo &frameInfo, GlobalUbo &ubo) {
+        const std::vector<RenderLight> &lights = frameInfo.renderState.lights;
+        assert(lights.size() <= MAX_LIGHTS && "Point lights exceed maximum specifed");
 
-            lightIndex += 1;
+        for (size_t i = 0; i < lights.size(); i++) {
+            ubo.pointLights[i].position = glm::vec4(lights[i].position, 1.f);
+            ubo.pointLights[i].color = lights[i].color;
         }
 
-        ubo.numLights = lightIndex;
+        ubo.numLights = static_cast<int>(lights.size());
     }
 
     void PointLightSystem::render(FrameInfo &frameInfo)
     {
-        std::map<float, LveGameObject::id_t> sorted;
-        for (auto& kv : frameInfo.gameObjects) {
-            auto& obj = kv.second;
-            if (obj.pointLight == nullptr) continue;
-
-            auto offset = frameInfo.camera.getPosition() - obj.transform.translation;
+        std::multimap<float, const RenderLight *> sorted;
+        for (const RenderLight &light : frameInfo.renderState.lights) {
+            auto offset = frameInfo.camera.getPosition() - light.position;
             float disSquared = glm::dot(offset, offset);
-            sorted[disSquared] = obj.getId();
+            sorted.emplace(disSquared, &light);
         }
 
-        this->lvePipeline->bind(frameInfo.commandBuffer);
+        this->lvePipeline.get()->bind(frameInfo.commandBuffer);
         vkCmdBindDescriptorSets(
             frameInfo.commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -113,11 +117,11 @@ namespace lve
             nullptr);
 
         for (auto it = sorted.rbegin(); it != sorted.rend(); ++it) {
-            auto& obj = frameInfo.gameObjects.at(it->second);
+            const RenderLight &light = *it->second;
             PointLightPushConstants push{};
-            push.position = glm::vec4(obj.transform.translation, 1.f);
-            push.color = glm::vec4(obj.color, obj.pointLight->lightIntesity);
-            push.radius = obj.transform.scale.x;
+            push.position = glm::vec4(light.position, 1.f);
+            push.color = light.color;
+            push.radius = light.radius;
 
             vkCmdPushConstants(
                 frameInfo.commandBuffer,
@@ -2,9 +2,11 @@
 
 #include "lve_camera.hpp"
 #include "lve_pipeline.hpp"
-#include "lve_game_object.hpp"
+#include "lve_pipeline_service.hpp"
+#include "lve_scene.hpp"
 #include "lve_device.hpp"
 #include "lve_frame_info.hpp"
+#include "lve_job_system.hpp"
 
 #include <memory>
 #include <vector>
@@ -14,22 +16,32 @@ namespace lve
     class PointLightSystem
     {
     public:
-        PointLightSystem(LveDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        // lights moved per job, small scenes update on the calling thread
+        static constexpr uint32_t LIGHT_UPDATE_GRAIN = 256;
+
+        PointLightSystem(
+            LveDevice &device,
+            LvePipelineService &pipelineService,
+            const PipelineRenderTarget &renderTarget,
+            VkDescriptorSetLayout globalSetLayout);
         ~PointLightSystem();
 
         PointLightSystem(const PointLightSystem &) = delete;
         PointLightSystem &operator=(const PointLightSystem &) = delete;
 
-        void update(FrameInfo &frameInfo, GlobalUbo &ubo);
+        // simulation side, moves the lights
+        void update(float frameTime, LveScene &scene, LveJobSystem &jobSystem);
+        // render side, from the lights extracted into frameInfo.renderState
+        void writeLights(FrameInfo &frameInfo, GlobalUbo &ubo);
         void render(FrameInfo &frameInfo);
 
     private:
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        void createPipeline(LvePipelineService &pipelineService, const PipelineRenderTarget &renderTarget);
 
         LveDevice &lveDevice;
 
-        std::unique_ptr<LvePipeline> lvePipeline;
+        LvePipelineService::Handle lvePipeline;
         VkPipelineLayout pipelineLayout;
     };
 }
@@ -0,0 +1,5 @@
+#version 450
+
+// depth pre-pass, only the depth attachment is written
+void main() {
+}
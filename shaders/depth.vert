@@ -0,0 +1,36 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+
+struct PointLight {
+  vec4 position;
+  vec4 color;
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 invView;
+  vec4 ambientLightColor; // w is intensity
+  PointLight pointLights[10];
+  int numLights;
+} ubo;
+
+struct ObjectData {
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+    uint material;
+};
+
+layout(std140, set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+} objectBuffer;
+
+// must match shader.vert bit for bit, the main pass depth test is VK_COMPARE_OP_EQUAL
+invariant gl_Position;
+
+void main() {
+    ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+    vec4 positionWorld = object.modelMatrix * vec4(position, 1.0);
+    gl_Position = ubo.projection * ubo.view * positionWorld;
+}
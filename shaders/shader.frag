@@ -1,8 +1,14 @@
 #version 450
 
+// compiled a second time with BINDLESS defined into bindless_frag.spv
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec3 fragPosWorld;
 layout(location = 2) in vec3 fragNormalWorld;
+layout(location = 3) flat in uint fragMaterial;
 
 layout(location = 0) out vec4 outColor;
 
@@ -11,6 +17,12 @@ struct PointLight {
   vec4 color;
 };
 
+// specialization constants, set per pipeline by LveRenderSystem::LightingVariant. The light
+// array keeps its full size so the ubo layout matches GlobalUbo for every variant.
+layout(constant_id = 0) const int MAX_LIGHTS = 10;
+layout(constant_id = 1) const float SPECULAR_EXPONENT = 32.0;
+layout(constant_id = 2) const bool ENABLE_SPECULAR = false;
+
 layout(set = 0, binding = 0) uniform GlobalUbo {
   mat4 projection;
   mat4 view;
@@ -20,10 +32,16 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
   int numLights;
 } ubo;
 
-layout(push_constant) uniform Push {
-    mat4 transform;
-    mat4 normalMatrix;
-} push;
+#ifdef BINDLESS
+struct Material {
+  vec4 tint;
+};
+
+// the storage buffers of LveBindlessResources, each holding one material
+layout(std430, set = 2, binding = 0) readonly buffer MaterialBuffer {
+  Material material;
+} materials[];
+#endif
 
 void main() {
     vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
@@ -33,7 +51,11 @@ void main() {
     vec3 cameraPosWorld = ubo.invView[3].xyz;
     vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld);
 
-    for (int i = 0; i < ubo.numLights; i++) {
+    // constant trip count so the compiler can unroll, lights past numLights are skipped
+    for (int i = 0; i < MAX_LIGHTS; i++) {
+      if (i >= ubo.numLights) {
+        break;
+      }
       PointLight light = ubo.pointLights[i];
       vec3 directionToLight = light.position.xyz - fragPosWorld;
       float attenuation = 1.0 / dot(directionToLight, directionToLight);
@@ -44,12 +66,20 @@ void main() {
 
       diffuseLight += intensity * cosAngIncidence;
 
+      if (!ENABLE_SPECULAR) {
+        continue;
+      }
       vec3 halfAngle = normalize(directionToLight + viewDirection);
       float blinnTerm = dot(surfaceNormal, halfAngle);
       blinnTerm = clamp(blinnTerm, 0, 1);
-      blinnTerm = pow(blinnTerm, 32.0);
+      blinnTerm = pow(blinnTerm, SPECULAR_EXPONENT);
       specularLight += intensity * blinnTerm;
     }
 
-    outColor = vec4(diffuseLight * fragColor, 1.0);
+#ifdef BINDLESS
+    vec3 tint = materials[nonuniformEXT(fragMaterial)].material.tint.rgb;
+#else
+    vec3 tint = vec3(1.0);
+#endif
+    outColor = vec4((diffuseLight * fragColor + specularLight * fragColor) * tint, 1.0);
 }
@@ -0,0 +1,81 @@
+#include "../little_vulkan_engine/lve_device.hpp"
+#include "../little_vulkan_engine/lve_geometry_pool.hpp"
+#include "../little_vulkan_engine/lve_job_system.hpp"
+#include "../little_vulkan_engine/lve_model.hpp"
+#include "../little_vulkan_engine/lve_window.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// Creates and destroys models on every job worker at once, then checks that the geometry pool
+// got all of its memory back. Takes the round count as its only argument.
+static constexpr int DEFAULT_ROUNDS = 100;
+static constexpr uint32_t MODELS_PER_ROUND = 64;
+
+static void runModelStress(
+    lve::LveDevice &device,
+    lve::LveGeometryPool &geometryPool,
+    lve::LveJobSystem &jobSystem,
+    int rounds) {
+    // Half the models are evicted and reloaded to hit free and allocate twice.
+    auto builder = std::make_shared<lve::LveModel::Builder>();
+    builder->loadModel("models/smooth_vase.obj");
+    VkDeviceSize usedMemory = geometryPool.getUsedMemory();
+
+    std::vector<std::exception_ptr> errors(MODELS_PER_ROUND);
+    for (int round = 0; round < rounds; round++) {
+        jobSystem.parallelFor(MODELS_PER_ROUND, 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                try {
+                    lve::LveModel model{geometryPool, builder};
+                    if (i % 2 == 0) {
+                        model.releaseBuffers();
+                        model.makeResident();
+                    }
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+        });
+
+        for (const std::exception_ptr &error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+        geometryPool.endFrame();
+    }
+
+    // frees are handed back a full frames-in-flight after they were made
+    for (uint32_t i = 0; i < device.getFramesInFlight(); i++) {
+        geometryPool.endFrame();
+    }
+
+    if (geometryPool.getUsedMemory() != usedMemory) {
+        throw std::runtime_error("model stress test leaked geometry pool memory");
+    }
+
+    std::cout << "model stress: " << rounds * MODELS_PER_ROUND << " models on "
+              << jobSystem.getWorkerCount() << " job workers passed\n";
+}
+
+int main(int argc, char **argv) {
+    int rounds = argc > 1 ? std::max(0, std::atoi(argv[1])) : DEFAULT_ROUNDS;
+    try {
+        lve::LveJobSystem jobSystem{};
+        lve::LveWindow window{800, 600, "Model Stress"};
+        lve::LveDevice device{window};
+        lve::LveGeometryPool geometryPool{device, lve::LveModel::Vertex::getStreamStrides()};
+        runModelStress(device, geometryPool, jobSystem, rounds);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}